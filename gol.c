@@ -9,33 +9,85 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include "gol_cmd.h"
 #include "gol_io.h"
 #include "gol_sim.h"
+#include "gol_ckpt.h"
+#include "gol_batch.h"
+#include "gol_dist.h"
+#include "gol_export.h"
 
 int main(int argv, char** argc) {
     // declare data to hold cmd line information
-    int wrap, show, speed;
-    char* filename = NULL;
-    // initialize int** to store board information after read file       
-    int** board;
+    gol_opts opts;
+    // initialize gol_board* to store board information after read file       
+    gol_board* board;
     // store information about the board dimensions and simulation steps
-    int row, col, iter; 
+    int row, col;
+    long iter;
 
     // parse command line argument and store success/failure status
-    int status = parse_cmd(argv, argc, &filename, &wrap, &show, &speed);
+    int status = parse_cmd(argv, argc, &opts);
     // if it failed, return -1
     if(status == -1){
         printf("program failed for the above reason(s)\n");
         return -1;
     }
+    // a frame file is only played back, nothing is stepped
+    if (opts.replay != NULL) {
+        return run_replay(&opts);
+    }
+    // every engine steps with the rule from -r
+    set_rule(&opts.rule);
+    // a manifest of boards is run by the batch workers (see gol_batch.c)
+    if (opts.batch != NULL) {
+        return run_batch(&opts);
+    }
 
     // read the file and return row, col, iter by reference, store board
-    board = read_file(filename, &row, &col, &iter);
+    struct timeval loadStart, loadEnd;
+    gettimeofday(&loadStart, NULL);
+    if (opts.resume != NULL) {
+        // the snapshot knows its generation and where the run stops
+        long total;
+        board = load_snapshot(opts.resume, opts.wrap, &opts.start_gen, &total);
+        row = board->row;
+        col = board->col;
+        iter = total - opts.start_gen;
+    }
+    else {
+        board = read_file(opts.filename, NULL, &row, &col, &iter);
+    }
+    gettimeofday(&loadEnd, NULL);
+    double loadTime = (loadEnd.tv_sec - loadStart.tv_sec) + (loadEnd.tv_usec - loadStart.tv_usec) / 1e6;
+
+    // -n overrides the file, and is the only count for formats that don't store one
+    // (after --resume it is still counted from generation 0)
+    if (opts.iterations >= 0) {
+        iter = opts.iterations - opts.start_gen;
+    }
+    if (iter < 0 && opts.resume != NULL) {
+        printf("error: the snapshot is already past generation %ld\n\n", opts.iterations);
+        return -1;
+    }
+    if (iter < 0) {
+        printf("error: '%s' has no iteration count, give one with -n\n\n", opts.filename);
+        return -1;
+    }
 
     // simulate the game of life passing the board and the necessary 
-    // information for simulating and output
-    simulate_board(board, row, col, iter, wrap, show, speed);
+    // information for simulating and output, split across processes with -p
+    if (opts.procs > 1) {
+        run_dist(board, iter, &opts);
+    }
+    else {
+        simulate_board(board, iter, &opts);
+    }
+
+    // kept apart from the simulation time printed above
+    printf("Load time for %dx%d from %s is %.6f\n", row, col,
+           opts.resume != NULL ? opts.resume : opts.filename, loadTime);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_arena.c
+ * This file is the arena the simulation takes its boards from. Everything a run steps
+ * through is sized before the first generation and carved out of one anonymous mapping,
+ * so the loop itself never allocates. The mapping starts on a huge page boundary and is
+ * backed by explicit huge pages (MAP_HUGETLB) when the system has some reserved, and
+ * otherwise by normal pages with a request to fold them into huge ones (madvise), which
+ * cuts the TLB misses of sweeping a large board every generation. The kernel hands the
+ * mapping out zeroed, so boards carved from it start dead without being cleared.
+ * Built with make ALLOCS=1, this file also counts every heap allocation the process
+ * makes, so a run can show that none happen between the first and last generation.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "gol_arena.h"
+#include "gol_io.h"
+
+/* create_arena(size_t);
+ * Create arena maps at least bytes of zeroed memory, rounded up to whole huge pages.
+ * @param bytes: everything that will be carved from it (see arena_board_bytes)
+ * @return: the arena
+ */
+gol_arena* create_arena(size_t bytes) {
+    gol_arena* arena = malloc(sizeof(gol_arena));
+    size_t size = (bytes + ARENA_HUGE - 1) / ARENA_HUGE * ARENA_HUGE;
+    if (size == 0) {
+        size = ARENA_HUGE;
+    }
+    arena->size = size;
+    arena->used = 0;
+    arena->huge = 0;
+
+#ifdef MAP_HUGETLB
+    // explicit huge pages only exist if the administrator reserved some
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED) {
+        arena->base = base;
+        arena->huge = 1;
+        return arena;
+    }
+#endif
+    // map a huge page more than needed and trim both ends so the start is aligned
+    char* raw = mmap(NULL, size + ARENA_HUGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        printf("error: unable to map %zu bytes for the boards\n", size);
+        exit(-1);
+    }
+    char* start = (char*)(((uintptr_t)raw + ARENA_HUGE - 1) & ~(uintptr_t)(ARENA_HUGE - 1));
+    if (start > raw) {
+        munmap(raw, start - raw);
+    }
+    munmap(start + size, raw + ARENA_HUGE - start);
+#ifdef MADV_HUGEPAGE
+    madvise(start, size, MADV_HUGEPAGE);
+#endif
+    arena->base = start;
+    return arena;
+}
+
+/* arena_alloc(gol_arena*, size_t);
+ * Hands out the next bytes of the arena, GOL_ALIGN aligned and zeroed. Nothing is given
+ * back until the whole arena is freed. The arena is sized up front, so running out is a
+ * bug rather than something to recover from.
+ * @param arena: the arena
+ * @param bytes: size of the block
+ * @return: the block
+ */
+void* arena_alloc(gol_arena* arena, size_t bytes) {
+    size_t at = (arena->used + GOL_ALIGN - 1) / GOL_ALIGN * GOL_ALIGN;
+    if (at + bytes > arena->size) {
+        printf("error: arena of %zu bytes is full\n", arena->size);
+        exit(-1);
+    }
+    arena->used = at + bytes;
+    return arena->base + at;
+}
+
+/* arena_board_bytes(int, int);
+ * @return: bytes of the arena a ROWxCOL board takes, board and cells together
+ */
+size_t arena_board_bytes(int row, int col) {
+    gol_board shape;
+    size_t header = (sizeof(gol_board) + GOL_ALIGN - 1) / GOL_ALIGN * GOL_ALIGN;
+    return header + board_layout(&shape, row, col);
+}
+
+/* arena_board(gol_arena*, int, int);
+ * Arena board is create_empty_board with the board and its cells carved from the arena.
+ * The cells are already 0, so nothing is cleared. free_array leaves such a board alone;
+ * it goes away with the arena.
+ * @param arena: the arena
+ * @param row: number of rows
+ * @param col: number of cols
+ * @return: the empty board
+ */
+gol_board* arena_board(gol_arena* arena, int row, int col) {
+    gol_board* board = arena_alloc(arena, sizeof(gol_board));
+    board->bytes = board_layout(board, row, col);
+    board->cells = arena_alloc(arena, board->bytes);
+    board->map = NULL;
+    board->mapBytes = 0;
+    board->arena = arena;
+    board->hashes = NULL;
+#ifdef GOL_STATS
+    board->counts = NULL;
+#endif
+    return board;
+}
+
+/* free_arena(gol_arena**);
+ * Unmaps the arena, along with every board carved from it, and sets the caller's
+ * pointer to NULL.
+ * @param parena: pointer to the gol_arena*
+ */
+void free_arena(gol_arena** parena) {
+    munmap((*parena)->base, (*parena)->size);
+    free(*parena);
+    *parena = NULL;
+}
+
+#ifdef GOL_ALLOCS
+// glibc's allocator, which the replacements below count and pass on to
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void* __libc_memalign(size_t, size_t);
+extern void __libc_free(void*);
+
+// heap allocations so far, by every thread
+static long allocs = 0;
+
+/* gol_allocs();
+ * @return: number of heap allocations (malloc, calloc, realloc, posix_memalign and
+ * aligned_alloc) the process has made so far
+ */
+long gol_allocs(void) {
+    return __atomic_load_n(&allocs, __ATOMIC_RELAXED);
+}
+
+void* malloc(size_t bytes) {
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(bytes);
+}
+
+void* calloc(size_t n, size_t bytes) {
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(n, bytes);
+}
+
+void* realloc(void* p, size_t bytes) {
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(p, bytes);
+}
+
+int posix_memalign(void** p, size_t align, size_t bytes) {
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    *p = __libc_memalign(align, bytes);
+    return (*p == NULL && bytes > 0) ? ENOMEM : 0;
+}
+
+void* aligned_alloc(size_t align, size_t bytes) {
+    __atomic_add_fetch(&allocs, 1, __ATOMIC_RELAXED);
+    return __libc_memalign(align, bytes);
+}
+
+void free(void* p) {
+    __libc_free(p);
+}
+#endif
@@ -0,0 +1,27 @@
+#ifndef GOL_ARENA_H
+#define GOL_ARENA_H
+
+#include <stddef.h>
+#include "gol_board.h"
+
+// size of a huge page, the arena is a whole number of them and starts on one
+#define ARENA_HUGE (2UL << 20)
+
+// one mapping made up front that boards and scratch memory are carved from
+typedef struct gol_arena {
+    char* base;         // start of the mapping, ARENA_HUGE aligned
+    size_t size;        // bytes in the mapping
+    size_t used;        // bytes handed out so far
+    int huge;           // 1 = explicit huge pages (MAP_HUGETLB), 0 = normal pages, huge if the kernel folds them (madvise)
+} gol_arena;
+
+gol_arena* create_arena(size_t);
+void* arena_alloc(gol_arena*, size_t);
+size_t arena_board_bytes(int, int);
+gol_board* arena_board(gol_arena*, int, int);
+void free_arena(gol_arena**);
+#ifdef GOL_ALLOCS
+long gol_allocs(void);
+#endif
+
+#endif
@@ -0,0 +1,179 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_avx2.c
+ * AVX2 version of the bit-parallel kernel in gol_swar.c. The same full-adder logic runs
+ * on 256-bit registers, so every instruction works on 4 words (256 cells) of a row.
+ * On x86 the kernel is compiled for AVX2 through a target attribute, so only it uses
+ * AVX2 instructions; anywhere else (or on a CPU without AVX2, see avx2_supported in
+ * gol_simd.c) the portable swar_row is used instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "gol_simd.h"
+#include "gol_swar.h"
+#include "gol_rule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// only the functions marked with this use AVX2, the rest of the program (and the check
+// in gol_simd.c that picks this kernel) runs on any x86 CPU
+#define AVX2_FN __attribute__((target("avx2")))
+
+// number of words in one vector
+#define LANES 4
+
+/* shift_vec(__m256i, __m256i, __m256i, __m256i*, __m256i*);
+ * Builds the west and east neighbour planes of the chunk x. The bit moved in at each end
+ * of a word comes from the word next to it, which for the first/last lane lives in the
+ * previous (p) or next (n) chunk of the row.
+ */
+static inline AVX2_FN void shift_vec(__m256i p, __m256i x, __m256i n, __m256i* west, __m256i* east) {
+    // [p3, x0, x1, x2] and [x1, x2, x3, n0]
+    __m256i xp = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x93),
+                                    _mm256_permute4x64_epi64(p, 0x93), 0x03);
+    __m256i xn = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x39),
+                                    _mm256_permute4x64_epi64(n, 0x39), 0xC0);
+    *west = _mm256_or_si256(_mm256_slli_epi64(x, 1), _mm256_srli_epi64(xp, 63));
+    *east = _mm256_or_si256(_mm256_srli_epi64(x, 1), _mm256_slli_epi64(xn, 63));
+}
+
+/* full_add(__m256i, __m256i, __m256i, __m256i*, __m256i*);
+ * Adds three bitplanes, see full_add in gol_swar.c
+ */
+static inline AVX2_FN void full_add(__m256i a, __m256i b, __m256i c, __m256i* sum, __m256i* carry) {
+    __m256i t = _mm256_xor_si256(a, b);
+    *sum = _mm256_xor_si256(t, c);
+    *carry = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(t, c));
+}
+
+/* rule_vec(__m256i, __m256i, __m256i, __m256i, __m256i, const __m256i*, const __m256i*);
+ * Applies any rule to the 256 cells m from their count planes, see rule_word in gol_swar.c
+ * @param born, survive: one all 0's or all 1's vector per count, from the rule's masks
+ * @return: the 256 cells of the next generation
+ */
+static inline AVX2_FN __m256i rule_vec(__m256i ones, __m256i twos, __m256i fours, __m256i eights, __m256i m,
+                               const __m256i* born, const __m256i* survive) {
+    __m256i all = _mm256_set1_epi64x(-1);
+    __m256i lo[4] = {_mm256_andnot_si256(_mm256_or_si256(ones, twos), all), _mm256_andnot_si256(twos, ones),
+                     _mm256_andnot_si256(ones, twos), _mm256_and_si256(ones, twos)};
+    __m256i hi[3] = {_mm256_andnot_si256(_mm256_or_si256(fours, eights), all), fours, eights};
+    __m256i b = _mm256_setzero_si256(), s = b;
+    for (int k = 0; k <= 8; k++) {
+        __m256i eq = _mm256_and_si256(lo[k & 3], hi[k >> 2]);
+        b = _mm256_or_si256(b, _mm256_and_si256(eq, born[k]));
+        s = _mm256_or_si256(s, _mm256_and_si256(eq, survive[k]));
+    }
+    return _mm256_or_si256(_mm256_and_si256(m, s), _mm256_andnot_si256(m, b));
+}
+
+/* life_vec(three rows of previous, current and next chunks, int, const __m256i*, const __m256i*);
+ * Applies the rule to the 256 cells of chunk m, see life_word in gol_swar.c
+ * @param conway: 1 for B3/S23, otherwise born and survive are the rule (see rule_vec)
+ * @return: the 256 cells of the next generation
+ */
+static inline AVX2_FN __m256i life_vec(__m256i pu, __m256i u, __m256i nu, __m256i pm, __m256i m,
+                               __m256i nm, __m256i pd, __m256i d, __m256i nd,
+                               int conway, const __m256i* born, const __m256i* survive) {
+    __m256i uw, ue, mw, me, dw, de, su, cu, sd, cd, ones, c4, t1, f1;
+    shift_vec(pu, u, nu, &uw, &ue);
+    shift_vec(pm, m, nm, &mw, &me);
+    shift_vec(pd, d, nd, &dw, &de);
+    full_add(uw, u, ue, &su, &cu);
+    full_add(dw, d, de, &sd, &cd);
+    full_add(su, sd, _mm256_xor_si256(mw, me), &ones, &c4);
+    full_add(cu, cd, _mm256_and_si256(mw, me), &t1, &f1);
+    __m256i twos = _mm256_xor_si256(t1, c4);
+    __m256i f2 = _mm256_and_si256(t1, c4);
+    if (conway) {
+        __m256i more = _mm256_or_si256(f1, f2);
+        return _mm256_andnot_si256(more, _mm256_and_si256(twos, _mm256_or_si256(ones, m)));
+    }
+    return rule_vec(ones, twos, _mm256_xor_si256(f1, f2), _mm256_and_si256(f1, f2), m, born, survive);
+}
+
+/* load_chunk(const uint64_t*, int, int);
+ * @return: the chunk of the row starting at word w, or all 0's past the last word
+ */
+static inline AVX2_FN __m256i load_chunk(const uint64_t* row, int w, int last) {
+    return (w <= last) ? _mm256_load_si256((const __m256i*)(row + w)) : _mm256_setzero_si256();
+}
+
+/* vec_loop(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const __m256i*, const __m256i*);
+ * Steps every chunk of a row treating both ends as dead, see avx2_row.
+ * @param last: index of the last word holding cells
+ * @param conway, born, survive: the rule, see life_vec
+ */
+static inline AVX2_FN void vec_loop(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+                            int last, int conway, const __m256i* born, const __m256i* survive) {
+    __m256i pu = _mm256_setzero_si256(), pm = pu, pd = pu;
+    __m256i u = load_chunk(up, 0, last), m = load_chunk(mid, 0, last), d = load_chunk(dn, 0, last);
+
+    for (int w = 0; w <= last; w += LANES) {
+        __m256i nu = load_chunk(up, w + LANES, last);
+        __m256i nm = load_chunk(mid, w + LANES, last);
+        __m256i nd = load_chunk(dn, w + LANES, last);
+        _mm256_store_si256((__m256i*)(out + w), life_vec(pu, u, nu, pm, m, nm, pd, d, nd, conway, born, survive));
+        pu = u; u = nu;
+        pm = m; m = nm;
+        pd = d; d = nd;
+    }
+}
+
+/* avx2_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+ * Same as swar_row, 4 words at a time. Rows are aligned and padded to a cache line, so
+ * every chunk is an aligned load that stays inside the row. The vector loop treats both
+ * ends of the row as dead, then the first and last word are redone with swar_word,
+ * which knows about wrap and clears the padding bits. The scratch tiles of gol_tile.c
+ * are nowrap and a whole number of words wide, so they never need the fix up.
+ * @param up, mid, dn: rows above, at and below the row being updated
+ * @param out: where the new row is written
+ * @param col: number of columns in the row
+ * @param wrap: 1 to wrap around the board horizontally, 0 for dead edges
+ * @param rule: the rule to step with
+ */
+AVX2_FN void avx2_row(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+              int col, int wrap, const gol_rule* rule) {
+    int last = (col - 1) / GOL_WORD_BITS;
+    // the rule is checked once per row, each loop has its logic compiled in
+    if (rule->conway) {
+        vec_loop(up, mid, dn, out, last, 1, NULL, NULL);
+    }
+    else {
+        __m256i born[9], survive[9];
+        for (int k = 0; k <= 8; k++) {
+            born[k] = _mm256_set1_epi64x(-(long long)((rule->born >> k) & 1));
+            survive[k] = _mm256_set1_epi64x(-(long long)((rule->survive >> k) & 1));
+        }
+        vec_loop(up, mid, dn, out, last, 0, born, survive);
+    }
+    // padding words of the last chunk may have picked up births from the last word
+    for (int w = last + 1; w % LANES != 0; w++) {
+        out[w] = 0;
+    }
+    // the words at each end take their outside neighbours from the other edge, and the
+    // last word may have padding to clear (nothing to do for nowrap on whole words)
+    if (wrap || col % GOL_WORD_BITS != 0) {
+        out[0] = swar_word(up, mid, dn, 0, col, wrap, rule);
+        out[last] = swar_word(up, mid, dn, last, col, wrap, rule);
+    }
+}
+
+#else
+
+// not x86: never picked by auto, falls back to the portable kernel if forced
+void avx2_row(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+              int col, int wrap, const gol_rule* rule) {
+    swar_row(up, mid, dn, out, col, wrap, rule);
+}
+
+#endif
+
+/* update_board_avx2(const gol_board*, gol_board*, int);
+ * AVX2 replacement for update_board, same arguments and same result.
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+void update_board_avx2(const gol_board* old, gol_board* new, int wrap) {
+    step_rows(avx2_row, old, new, 0, old->row, wrap, &golRule);
+}
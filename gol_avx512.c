@@ -0,0 +1,181 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_avx512.c
+ * AVX-512 version of the bit-parallel kernel in gol_swar.c. Every instruction works on
+ * 8 words (512 cells, one whole cache line) of a row, and each full adder is two
+ * ternary-logic instructions. On x86 the kernel is compiled for AVX-512 through a
+ * target attribute, so only it uses AVX-512 instructions; anywhere else (or on a CPU
+ * without AVX-512, see avx512_supported in gol_simd.c) the portable swar_row is used
+ * instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "gol_simd.h"
+#include "gol_swar.h"
+#include "gol_rule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// only the functions marked with this use AVX-512, the rest of the program (and the check
+// in gol_simd.c that picks this kernel) runs on any x86 CPU
+#define AVX512_FN __attribute__((target("avx512f")))
+
+// number of words in one vector
+#define LANES 8
+
+/* shift_vec(__m512i, __m512i, __m512i, __m512i*, __m512i*);
+ * Builds the west and east neighbour planes of the chunk x. The bit moved in at each end
+ * of a word comes from the word next to it, which for the first/last lane lives in the
+ * previous (p) or next (n) chunk of the row.
+ */
+static inline AVX512_FN void shift_vec(__m512i p, __m512i x, __m512i n, __m512i* west, __m512i* east) {
+    // [p7, x0 .. x6] and [x1 .. x7, n0]
+    __m512i xp = _mm512_alignr_epi64(x, p, 7);
+    __m512i xn = _mm512_alignr_epi64(n, x, 1);
+    *west = _mm512_or_si512(_mm512_slli_epi64(x, 1), _mm512_srli_epi64(xp, 63));
+    *east = _mm512_or_si512(_mm512_srli_epi64(x, 1), _mm512_slli_epi64(xn, 63));
+}
+
+/* full_add(__m512i, __m512i, __m512i, __m512i*, __m512i*);
+ * Adds three bitplanes, see full_add in gol_swar.c. 0x96 is the truth table of
+ * a ^ b ^ c and 0xE8 the truth table of the majority of a, b and c.
+ */
+static inline AVX512_FN void full_add(__m512i a, __m512i b, __m512i c, __m512i* sum, __m512i* carry) {
+    *sum = _mm512_ternarylogic_epi64(a, b, c, 0x96);
+    *carry = _mm512_ternarylogic_epi64(a, b, c, 0xE8);
+}
+
+/* rule_vec(__m512i, __m512i, __m512i, __m512i, __m512i, const __m512i*, const __m512i*);
+ * Applies any rule to the 512 cells m from their count planes, see rule_word in gol_swar.c
+ * @param born, survive: one all 0's or all 1's vector per count, from the rule's masks
+ * @return: the 512 cells of the next generation
+ */
+static inline AVX512_FN __m512i rule_vec(__m512i ones, __m512i twos, __m512i fours, __m512i eights, __m512i m,
+                               const __m512i* born, const __m512i* survive) {
+    // 0x03 is the truth table of ~(a | b)
+    __m512i lo[4] = {_mm512_ternarylogic_epi64(ones, twos, twos, 0x03), _mm512_andnot_si512(twos, ones),
+                     _mm512_andnot_si512(ones, twos), _mm512_and_si512(ones, twos)};
+    __m512i hi[3] = {_mm512_ternarylogic_epi64(fours, eights, eights, 0x03), fours, eights};
+    __m512i b = _mm512_setzero_si512(), s = b;
+    for (int k = 0; k <= 8; k++) {
+        __m512i eq = _mm512_and_si512(lo[k & 3], hi[k >> 2]);
+        // 0xF8 is a | (b & c)
+        b = _mm512_ternarylogic_epi64(b, eq, born[k], 0xF8);
+        s = _mm512_ternarylogic_epi64(s, eq, survive[k], 0xF8);
+    }
+    // 0xCA is a ? b : c
+    return _mm512_ternarylogic_epi64(m, s, b, 0xCA);
+}
+
+/* life_vec(three rows of previous, current and next chunks, int, const __m512i*, const __m512i*);
+ * Applies the rule to the 512 cells of chunk m, see life_word in gol_swar.c
+ * @param conway: 1 for B3/S23, otherwise born and survive are the rule (see rule_vec)
+ * @return: the 512 cells of the next generation
+ */
+static inline AVX512_FN __m512i life_vec(__m512i pu, __m512i u, __m512i nu, __m512i pm, __m512i m,
+                               __m512i nm, __m512i pd, __m512i d, __m512i nd,
+                               int conway, const __m512i* born, const __m512i* survive) {
+    __m512i uw, ue, mw, me, dw, de, su, cu, sd, cd, ones, c4, t1, f1;
+    shift_vec(pu, u, nu, &uw, &ue);
+    shift_vec(pm, m, nm, &mw, &me);
+    shift_vec(pd, d, nd, &dw, &de);
+    full_add(uw, u, ue, &su, &cu);
+    full_add(dw, d, de, &sd, &cd);
+    full_add(su, sd, _mm512_xor_si512(mw, me), &ones, &c4);
+    full_add(cu, cd, _mm512_and_si512(mw, me), &t1, &f1);
+    // twos = t1 ^ c4, and 4 or more when f1 or both t1 and c4
+    __m512i twos = _mm512_xor_si512(t1, c4);
+    if (conway) {
+        __m512i more = _mm512_ternarylogic_epi64(f1, t1, c4, 0xF8);
+        return _mm512_andnot_si512(more, _mm512_and_si512(twos, _mm512_or_si512(ones, m)));
+    }
+    __m512i f2 = _mm512_and_si512(t1, c4);
+    return rule_vec(ones, twos, _mm512_xor_si512(f1, f2), _mm512_and_si512(f1, f2), m, born, survive);
+}
+
+/* load_chunk(const uint64_t*, int, int);
+ * @return: the chunk of the row starting at word w, or all 0's past the last word
+ */
+static inline AVX512_FN __m512i load_chunk(const uint64_t* row, int w, int last) {
+    return (w <= last) ? _mm512_load_si512((const void*)(row + w)) : _mm512_setzero_si512();
+}
+
+/* vec_loop(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const __m512i*, const __m512i*);
+ * Steps every chunk of a row treating both ends as dead, see avx512_row.
+ * @param last: index of the last word holding cells
+ * @param conway, born, survive: the rule, see life_vec
+ */
+static inline AVX512_FN void vec_loop(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+                            int last, int conway, const __m512i* born, const __m512i* survive) {
+    __m512i pu = _mm512_setzero_si512(), pm = pu, pd = pu;
+    __m512i u = load_chunk(up, 0, last), m = load_chunk(mid, 0, last), d = load_chunk(dn, 0, last);
+
+    for (int w = 0; w <= last; w += LANES) {
+        __m512i nu = load_chunk(up, w + LANES, last);
+        __m512i nm = load_chunk(mid, w + LANES, last);
+        __m512i nd = load_chunk(dn, w + LANES, last);
+        _mm512_store_si512((void*)(out + w), life_vec(pu, u, nu, pm, m, nm, pd, d, nd, conway, born, survive));
+        pu = u; u = nu;
+        pm = m; m = nm;
+        pd = d; d = nd;
+    }
+}
+
+/* avx512_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+ * Same as swar_row, 8 words at a time. Rows are aligned and padded to a cache line, so
+ * every chunk is an aligned load that stays inside the row. The vector loop treats both
+ * ends of the row as dead, then the first and last word are redone with swar_word,
+ * which knows about wrap and clears the padding bits. The scratch tiles of gol_tile.c
+ * are nowrap and a whole number of words wide, so they never need the fix up.
+ * @param up, mid, dn: rows above, at and below the row being updated
+ * @param out: where the new row is written
+ * @param col: number of columns in the row
+ * @param wrap: 1 to wrap around the board horizontally, 0 for dead edges
+ * @param rule: the rule to step with
+ */
+AVX512_FN void avx512_row(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+                int col, int wrap, const gol_rule* rule) {
+    int last = (col - 1) / GOL_WORD_BITS;
+    // the rule is checked once per row, each loop has its logic compiled in
+    if (rule->conway) {
+        vec_loop(up, mid, dn, out, last, 1, NULL, NULL);
+    }
+    else {
+        __m512i born[9], survive[9];
+        for (int k = 0; k <= 8; k++) {
+            born[k] = _mm512_set1_epi64(-(long long)((rule->born >> k) & 1));
+            survive[k] = _mm512_set1_epi64(-(long long)((rule->survive >> k) & 1));
+        }
+        vec_loop(up, mid, dn, out, last, 0, born, survive);
+    }
+    // padding words of the last chunk may have picked up births from the last word
+    for (int w = last + 1; w % LANES != 0; w++) {
+        out[w] = 0;
+    }
+    // the words at each end take their outside neighbours from the other edge, and the
+    // last word may have padding to clear (nothing to do for nowrap on whole words)
+    if (wrap || col % GOL_WORD_BITS != 0) {
+        out[0] = swar_word(up, mid, dn, 0, col, wrap, rule);
+        out[last] = swar_word(up, mid, dn, last, col, wrap, rule);
+    }
+}
+
+#else
+
+// not x86: never picked by auto, falls back to the portable kernel if forced
+void avx512_row(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+                int col, int wrap, const gol_rule* rule) {
+    swar_row(up, mid, dn, out, col, wrap, rule);
+}
+
+#endif
+
+/* update_board_avx512(const gol_board*, gol_board*, int);
+ * AVX-512 replacement for update_board, same arguments and same result.
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+void update_board_avx512(const gol_board* old, gol_board* new, int wrap) {
+    step_rows(avx512_row, old, new, 0, old->row, wrap, &golRule);
+}
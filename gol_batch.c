@@ -0,0 +1,304 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_batch.c
+ * This file runs many boards in one process, for sweeps over lots of small seeds where
+ * starting a process per board would cost more than the simulation. The manifest lists
+ * one pattern file per line (blank lines and lines starting with '#' are skipped).
+ * Every worker thread starts with an even share of the lines in its own deque and takes
+ * them from the front. A worker that runs out steals the back half of another worker's
+ * deque, so a few slow boards don't leave the other threads idle. Each worker keeps its
+ * two board buffers and its cycle detector from board to board, loading the next file
+ * straight into the old buffer when it is large enough, so a batch of same sized boards
+ * allocates only for its first few. Boards are stepped with the chosen engine until the
+ * count is reached or the board repeats (see gol_cycle.c). One summary line per board
+ * goes to the -o file (stdout by default) in manifest order once every board is done.
+ * A file that can not be run gets an error line in its place and the batch goes on.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gol_batch.h"
+#include "gol_io.h"
+
+/* read_manifest(gol_batch*, char*);
+ * Reads the manifest into memory and splits it into file names in place.
+ * @param b: the batch, text, files and count are set
+ * @param manifest: name of the manifest file
+ */
+static void read_manifest(gol_batch* b, char* manifest) {
+    FILE* in = fopen(manifest, "r");
+    if (in == NULL || fseek(in, 0, SEEK_END) != 0) {
+        printf("error: unable to read the manifest '%s'\n\n", manifest);
+        exit(-1);
+    }
+    long bytes = ftell(in);
+    rewind(in);
+    b->text = malloc(bytes + 1);
+    if (b->text == NULL || (long)fread(b->text, 1, bytes, in) != bytes) {
+        printf("error: unable to read the manifest '%s'\n\n", manifest);
+        exit(-1);
+    }
+    fclose(in);
+    b->text[bytes] = '\0';
+
+    // there are never more names than lines
+    int lines = 1;
+    for (long i = 0; i < bytes; i++) {
+        lines += (b->text[i] == '\n');
+    }
+    b->files = malloc(lines * sizeof(char*));
+    b->count = 0;
+    char* save = NULL;
+    for (char* line = strtok_r(b->text, "\r\n", &save); line != NULL; line = strtok_r(NULL, "\r\n", &save)) {
+        // trim blanks on both ends
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        char* end = line + strlen(line);
+        while (end > line && (end[-1] == ' ' || end[-1] == '\t')) {
+            *--end = '\0';
+        }
+        if (*line != '\0' && *line != '#') {
+            b->files[b->count++] = line;
+        }
+    }
+    if (b->count == 0) {
+        printf("error: the manifest '%s' lists no files\n\n", manifest);
+        exit(-1);
+    }
+}
+
+/* take_job(batch_worker*);
+ * Takes the next line from the worker's own deque, or steals the back half of the
+ * first other deque that still has lines.
+ * @return: index of the file to run, -1 when every deque is empty
+ */
+static int take_job(batch_worker* w) {
+    gol_batch* b = w->batch;
+    batch_deque* own = &b->deques[w->id];
+    pthread_mutex_lock(&own->lock);
+    if (own->lo < own->hi) {
+        int j = own->lo++;
+        pthread_mutex_unlock(&own->lock);
+        return j;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    for (int k = 1; k < b->nworkers; k++) {
+        batch_deque* victim = &b->deques[(w->id + k) % b->nworkers];
+        pthread_mutex_lock(&victim->lock);
+        int left = victim->hi - victim->lo;
+        if (left > 0) {
+            // the back half, the owner keeps working from the front
+            int hi = victim->hi;
+            int lo = hi - (left + 1) / 2;
+            victim->hi = lo;
+            pthread_mutex_unlock(&victim->lock);
+            pthread_mutex_lock(&own->lock);
+            own->lo = lo + 1;
+            own->hi = hi;
+            pthread_mutex_unlock(&own->lock);
+            w->steals++;
+            return lo;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return -1;
+}
+
+/* run_job(batch_worker*, int);
+ * Loads one file into the worker's buffers and steps it, skipping ahead once it repeats.
+ * A file that can not be loaded or has no count is not run, the reason is kept in its
+ * result and the worker goes on with the next file.
+ * @param w: the worker
+ * @param j: index of the file in the manifest
+ */
+static void run_job(batch_worker* w, int j) {
+    gol_batch* b = w->batch;
+    batch_result* res = &b->results[j];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    res->start = -1;
+    res->period = 0;
+
+    // the file goes into the old buffer when it fits, otherwise the buffer is replaced
+    int row, col;
+    long iter;
+    gol_load_error err;
+    gol_board* board = load_file(b->files[j], w->board, &row, &col, &iter, &err);
+    if (board == NULL) {
+        if (err.line == 0) {
+            snprintf(res->error, BATCH_ERROR, "%s", err.what);
+        }
+        else {
+            snprintf(res->error, BATCH_ERROR, "line %d: %s", err.line, err.what);
+        }
+        return;
+    }
+    if (w->board != NULL && board != w->board) {
+        free_array(&w->board);
+    }
+    w->board = board;
+    if (b->iterations >= 0) {
+        iter = b->iterations;
+    }
+    if (iter < 0) {
+        snprintf(res->error, BATCH_ERROR, "has no iteration count, give one with -n");
+        return;
+    }
+    gol_board* flex = reuse_board(w->flex, row, col);
+    if (w->flex != NULL && flex != w->flex) {
+        free_array(&w->flex);
+    }
+    res->row = row;
+    res->col = col;
+    res->iter = iter;
+
+    if (w->cycle == NULL) {
+        w->cycle = create_cycle(board, flex, 0, NULL);
+    }
+    else {
+        cycle_reset(w->cycle, board, flex, 0);
+    }
+    long count = 0;
+    while (count < iter) {
+        b->step(board, flex, b->wrap);
+        swap_board(&board, &flex);
+        count++;
+        // every whole period left is skipped once the board repeats
+        long period = cycle_check(w->cycle, board, count);
+        if (period > 0) {
+            count += (iter - count) / period * period;
+            res->start = w->cycle->start;
+            res->period = period;
+        }
+    }
+
+    long population = 0;
+    for (int r = 0; r < board->row; r++) {
+        const uint64_t* cells = board_row(board, r);
+        for (int k = 0; k < board->words; k++) {
+            population += __builtin_popcountll(cells[k]);
+        }
+    }
+    res->population = population;
+    // the boards may have swapped, both are kept for the next file
+    w->board = board;
+    w->flex = flex;
+    w->boards++;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    res->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* batch_loop(void*);
+ * Body of every worker: runs files until there are none left to take or steal.
+ * @param arg: the batch_worker
+ */
+static void* batch_loop(void* arg) {
+    batch_worker* w = arg;
+    int j;
+    while ((j = take_job(w)) >= 0) {
+        run_job(w, j);
+    }
+    return NULL;
+}
+
+/* run_batch(const gol_opts*);
+ * Run batch steps every file of the manifest on opts->threads threads (the calling
+ * thread is one of them) and writes one line per file:
+ *   file rows cols generations population period cycle_start seconds
+ * with period 0 and cycle_start -1 for a board that never repeated, or
+ *   file error: reason
+ * for a file that could not be run.
+ * @param opts: the batch command line (see parse_batch)
+ * @return: 0 once every line is written, 1 if any file could not be run
+ */
+int run_batch(const gol_opts* opts) {
+    gol_batch b;
+    memset(&b, 0, sizeof(b));
+    read_manifest(&b, opts->batch);
+    int engine = resolve_engine(opts->engine);
+    b.step = pick_engine(engine);
+    b.wrap = opts->wrap;
+    b.iterations = opts->iterations;
+    b.results = calloc(b.count, sizeof(batch_result));
+
+    // even shares to start with, stealing evens out the rest
+    b.nworkers = opts->threads < b.count ? opts->threads : b.count;
+    b.deques = calloc(b.nworkers, sizeof(batch_deque));
+    b.workers = calloc(b.nworkers, sizeof(batch_worker));
+    for (int i = 0; i < b.nworkers; i++) {
+        b.deques[i].lo = (long)b.count * i / b.nworkers;
+        b.deques[i].hi = (long)b.count * (i + 1) / b.nworkers;
+        pthread_mutex_init(&b.deques[i].lock, NULL);
+        b.workers[i].batch = &b;
+        b.workers[i].id = i;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 1; i < b.nworkers; i++) {
+        if (pthread_create(&b.workers[i].thread, NULL, batch_loop, &b.workers[i]) != 0) {
+            printf("error: unable to start batch thread %d\n", i);
+            exit(-1);
+        }
+    }
+    batch_loop(&b.workers[0]);
+    for (int i = 1; i < b.nworkers; i++) {
+        pthread_join(b.workers[i].thread, NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    FILE* out = stdout;
+    if (opts->output != NULL && (out = fopen(opts->output, "w")) == NULL) {
+        printf("error: unable to open '%s' for the batch summary\n", opts->output);
+        exit(-1);
+    }
+    double cells = 0;
+    int failed = 0;
+    fprintf(out, "# file rows cols generations population period cycle_start seconds\n");
+    for (int j = 0; j < b.count; j++) {
+        batch_result* r = &b.results[j];
+        if (r->error[0] != '\0') {
+            fprintf(out, "%s error: %s\n", b.files[j], r->error);
+            failed++;
+            continue;
+        }
+        fprintf(out, "%s %d %d %ld %ld %ld %ld %.6f\n", b.files[j], r->row, r->col, r->iter,
+                r->population, r->period, r->start, r->seconds);
+        cells += (double)r->row * r->col * (r->iter > 0 ? r->iter : 0);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    long steals = 0;
+    for (int i = 0; i < b.nworkers; i++) {
+        steals += b.workers[i].steals;
+    }
+    printf("Batch of %d boards from %s on %d thread(s) in %.6f, %.1f boards/s, %ld steals, %d not run\n",
+           b.count, opts->batch, b.nworkers, elapsed, b.count / elapsed, steals, failed);
+    printf("Throughput: %.3e cell updates/s using %s (skipped repeats included)\n",
+           cells / elapsed, engine_name(engine));
+
+    for (int i = 0; i < b.nworkers; i++) {
+        batch_worker* w = &b.workers[i];
+        // a worker whose files all failed may have no boards, or only the first
+        if (w->board != NULL) {
+            free_array(&w->board);
+        }
+        if (w->flex != NULL) {
+            free_array(&w->flex);
+        }
+        if (w->cycle != NULL) {
+            free_cycle(&w->cycle);
+        }
+        pthread_mutex_destroy(&b.deques[i].lock);
+    }
+    free(b.workers);
+    free(b.deques);
+    free(b.results);
+    free(b.files);
+    free(b.text);
+    return failed > 0;
+}
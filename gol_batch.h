@@ -0,0 +1,62 @@
+#ifndef GOL_BATCH_H
+#define GOL_BATCH_H
+
+#include <pthread.h>
+#include "gol_board.h"
+#include "gol_cmd.h"
+#include "gol_cycle.h"
+#include "gol_sim.h"
+
+// longest reason a board of the batch was not run
+#define BATCH_ERROR 128
+
+// what one board of the batch came to
+typedef struct batch_result {
+    int row;
+    int col;
+    long iter;          // generations run, -1 = no count in the file and no -n
+    long population;    // live cells at the end
+    long start;         // generation the board started repeating at, -1 = never
+    long period;        // generations per repeat, 0 = never
+    double seconds;     // load and stepping time of this board
+    char error[BATCH_ERROR];    // why the board was not run, empty if it was
+} batch_result;
+
+// manifest lines [lo, hi) one worker has not started yet
+typedef struct batch_deque {
+    int lo;             // the owner takes from here
+    int hi;             // other workers steal from here
+    pthread_mutex_t lock;
+} batch_deque;
+
+struct gol_batch;
+
+// one worker thread and the buffers it keeps from board to board
+typedef struct batch_worker {
+    struct gol_batch* batch;
+    int id;
+    pthread_t thread;
+    gol_board* board;   // current board, its buffer is reused for the next file
+    gol_board* flex;    // the board it swaps with
+    gol_cycle* cycle;   // cycle detector, reset for every board
+    long boards;        // boards this worker ran
+    long steals;        // times it took work from another worker
+} batch_worker;
+
+// a batch run of every file in a manifest
+typedef struct gol_batch {
+    char* text;         // the manifest, file names point into it
+    char** files;
+    int count;
+    batch_result* results;  // one per file, in manifest order
+    batch_deque* deques;    // one per worker
+    batch_worker* workers;
+    int nworkers;
+    int wrap;
+    long iterations;    // -n, -1 = the count in every file
+    step_fn step;
+} gol_batch;
+
+int run_batch(const gol_opts*);
+
+#endif
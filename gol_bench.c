@@ -0,0 +1,361 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_bench.c
+ * Benchmark driver, built and run with "make bench". Every engine is run on random
+ * boards of several sizes and densities and on the bundled patterns, wrapped and not.
+ * Each case is warmed up with runs of doubling length, which also size the timed runs,
+ * then run several times from the same starting board, and every step is timed on the
+ * monotonic clock with nothing printed in between. Results go to <prefix>.csv and
+ * <prefix>.json: cell updates per second over all timed runs, and the median and 99th
+ * percentile time of one generation. The row engines (swar, avx2, avx512) are also run
+ * on a worker pool (see gol_pool.c) of 2, 4, ... threads, up to the number of CPUs.
+ *   ./gol_bench [-o prefix] [-q] [-t max]  (-q: smaller sweep for a quick check,
+ *                                           -t: most threads to try, default the CPUs)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gol_io.h"
+#include "gol_sim.h"
+#include "gol_simd.h"
+#include "gol_tile.h"
+#include "gol_hash.h"
+#include "gol_sparse.h"
+#include "gol_pool.h"
+
+// timed runs per case, all from the same starting board
+#define BENCH_REPEATS 5
+// aim for timed runs of about this many seconds, within the generation limits below
+#define BENCH_RUN_SECONDS 0.05
+#define BENCH_MIN_GENS 4
+#define BENCH_MAX_GENS 2000
+// generations per pass for the tiled case
+#define BENCH_TILE_K 4
+// memory cap of the hashlife store in megabytes
+#define BENCH_HASH_MB 512
+
+// engines in the sweep, the tiled case uses the widest row kernel with -k
+#define BENCH_TILED -1
+static const int benchEngines[] = {ENGINE_SCALAR, ENGINE_SWAR, ENGINE_AVX2, ENGINE_AVX512, BENCH_TILED,
+                                   ENGINE_SPARSE, ENGINE_HASHLIFE};
+static const int benchSizes[] = {256, 1024, 4096};
+static const double benchDensities[] = {0.05, 0.25, 0.5};
+static const char* benchPatterns[] = {"glidergun.txt", "gliderwrap.txt", "oscillator.txt", "pentadec.txt",
+                                      "spaceship.txt"};
+
+// thread counts tried are doubled from 1 up to the limit, which is tried last
+#define BENCH_MAX_THREADS 64
+
+// one measured case
+typedef struct bench_result {
+    char engine[32];
+    int threads;            // threads stepping the board, 1 unless on a worker pool
+    int wrap;
+    char workload[32];      // "random" or the pattern file
+    int row, col;
+    double density;         // fill of a random board, -1 for a pattern
+    long gens;              // generations timed over all repeats
+    double updates;         // cell updates per second
+    double median;          // seconds for one generation
+    double p99;
+} bench_result;
+
+/* now_seconds();
+ * @return: the monotonic clock in seconds
+ */
+static double now_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* random_board(int, double);
+ * Fills an n x n board so each cell is alive with probability density. Seeded, so every
+ * run of the benchmark steps the same boards.
+ */
+static gol_board* random_board(int n, double density) {
+    gol_board* board = create_empty_board(n, n);
+    uint64_t x = 0x9E3779B97F4A7C15ULL ^ (uint64_t)n;
+    uint64_t cut = (uint64_t)(density * 18446744073709551615.0);
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            // xorshift64
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            if (x < cut) {
+                set_cell(board, r, c, 1);
+            }
+        }
+    }
+    return board;
+}
+
+/* copy_board(gol_board*, const gol_board*);
+ * Copies the cells of a board of the same size.
+ */
+static void copy_board(gol_board* to, const gol_board* from) {
+    memcpy(to->cells, from->cells, (size_t)from->row * from->stride * sizeof(uint64_t));
+}
+
+/* compare_doubles(const void*, const void*);
+ * qsort order for the generation times.
+ */
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* pooled(int);
+ * @return: 1 if the engine can step on a worker pool (a row kernel)
+ */
+static int pooled(int engine) {
+    return engine == ENGINE_SWAR || engine == ENGINE_AVX2 || engine == ENGINE_AVX512;
+}
+
+/* run_gens(int, int, const gol_board*, int, long, double*);
+ * Steps a copy of start for gens generations with one engine, timing every step. A
+ * tile pass or a hashlife jump covers several generations, and its time is spread
+ * evenly over them. Engine state (tiles, the hashlife store, the worker pool) is built
+ * before the clock starts, so every run starts cold from the same board.
+ * @param engine: ENGINE_* or BENCH_TILED
+ * @param threads: threads stepping the board, more than 1 only for a pooled engine
+ * @param start: board to start from
+ * @param wrap: 1 wrap, 0 nowrap
+ * @param gens: generations to run
+ * @param times: gens entries, seconds per generation, can be NULL
+ * @return: total seconds spent stepping, -1 if the hashlife store can't hold the board
+ */
+static double run_gens(int engine, int threads, const gol_board* start, int wrap, long gens, double* times) {
+    gol_board* board = create_empty_board(start->row, start->col);
+    gol_board* flex = create_empty_board(start->row, start->col);
+    copy_board(board, start);
+
+    int kernelEngine = resolve_engine(ENGINE_AUTO);
+    step_fn step = pick_engine(engine == BENCH_TILED || engine == ENGINE_HASHLIFE ? kernelEngine : engine);
+    // the default tile (see gol_cmd.c), create_tiler keeps it inside the board
+    gol_tiler* tiler = engine == BENCH_TILED ?
+        create_tiler(board, BENCH_TILE_K, 256, 8192, pick_row_kernel(kernelEngine)) : NULL;
+    gol_hash* hash = engine == ENGINE_HASHLIFE ? create_hash(board, BENCH_HASH_MB) : NULL;
+    gol_sparse* sparse = engine == ENGINE_SPARSE ? create_sparse(board) : NULL;
+    gol_pool* pool = threads > 1 ? create_pool(threads, board->row, pick_row_kernel(engine), wrap) : NULL;
+
+    double total = 0;
+    long count = 0;
+    while (count < gens) {
+        long advanced = 1;
+        double t0 = now_seconds();
+        long jumped = (hash != NULL) ? hash_advance(hash, board, gens - count) : 0;
+        if (jumped < 0) {
+            // the board does not fit in BENCH_HASH_MB, the case is left out
+            total = -1;
+            break;
+        }
+        if (jumped > 0) {
+            advanced = jumped;
+        }
+        else {
+            if (tiler != NULL && gens - count >= tiler->k) {
+                tile_pass(tiler, board, flex, wrap);
+                advanced = tiler->k;
+            }
+            else if (sparse != NULL) {
+                sparse_step(sparse, board, flex, wrap);
+            }
+            else if (pool != NULL) {
+                pool_step(pool, board, flex);
+            }
+            else {
+                step(board, flex, wrap);
+            }
+            swap_board(&board, &flex);
+        }
+        double spent = now_seconds() - t0;
+        for (long g = 0; times != NULL && g < advanced; g++) {
+            times[count + g] = spent / advanced;
+        }
+        total += spent;
+        count += advanced;
+    }
+
+    if (tiler != NULL) {
+        free_tiler(&tiler);
+    }
+    if (hash != NULL) {
+        free_hash(&hash);
+    }
+    if (sparse != NULL) {
+        free_sparse(&sparse);
+    }
+    if (pool != NULL) {
+        free_pool(&pool);
+    }
+    free_array(&board);
+    free_array(&flex);
+    return total;
+}
+
+/* bench_case(int, int, const gol_board*, int, bench_result*);
+ * Warms up with runs of doubling length until one takes a quarter of BENCH_RUN_SECONDS
+ * (long enough for tile passes and hashlife jumps to show up), sizes the timed runs
+ * from the last one, runs BENCH_REPEATS of them and fills in the throughput and the
+ * generation time percentiles.
+ * @return: 0 if the case ran, -1 if the engine can't run it here (or within its memory)
+ */
+static int bench_case(int engine, int threads, const gol_board* start, int wrap, bench_result* res) {
+    if ((engine == ENGINE_AVX2 && !avx2_supported()) || (engine == ENGINE_AVX512 && !avx512_supported()) ||
+        (engine == ENGINE_HASHLIFE && !wrap) || (threads > 1 && !pooled(engine))) {
+        return -1;
+    }
+    long gens = BENCH_MIN_GENS;
+    double warm = run_gens(engine, threads, start, wrap, gens, NULL);
+    while (warm >= 0 && warm < BENCH_RUN_SECONDS / 4 && gens < BENCH_MAX_GENS) {
+        gens *= 2;
+        warm = run_gens(engine, threads, start, wrap, gens, NULL);
+    }
+    if (warm < 0) {
+        return -1;
+    }
+    gens = warm > 0 ? (long)(gens * BENCH_RUN_SECONDS / warm) : BENCH_MAX_GENS;
+    gens = gens < BENCH_MIN_GENS ? BENCH_MIN_GENS : gens > BENCH_MAX_GENS ? BENCH_MAX_GENS : gens;
+
+    long samples = gens * BENCH_REPEATS;
+    double* times = malloc(samples * sizeof(double));
+    double total = 0;
+    for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+        double spent = run_gens(engine, threads, start, wrap, gens, times + rep * gens);
+        if (spent < 0) {
+            free(times);
+            return -1;
+        }
+        total += spent;
+    }
+    qsort(times, samples, sizeof(double), compare_doubles);
+
+    snprintf(res->engine, sizeof(res->engine), "%s%s", engine == BENCH_TILED ?
+             engine_name(resolve_engine(ENGINE_AUTO)) : engine_name(engine), engine == BENCH_TILED ? "-k4" : "");
+    res->threads = threads;
+    res->wrap = wrap;
+    res->row = start->row;
+    res->col = start->col;
+    res->gens = samples;
+    res->updates = (double)start->row * start->col * samples / total;
+    res->median = times[samples / 2];
+    res->p99 = times[(samples * 99 + 99) / 100 - 1];
+    free(times);
+    return 0;
+}
+
+/* write_reports(const char*, const bench_result*, int);
+ * Writes every result to <prefix>.csv and <prefix>.json.
+ */
+static void write_reports(const char* prefix, const bench_result* res, int count) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s.csv", prefix);
+    FILE* csv = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.json", prefix);
+    FILE* json = fopen(path, "w");
+    if (csv == NULL || json == NULL) {
+        printf("error: unable to write the reports for '%s'\n", prefix);
+        exit(-1);
+    }
+
+    fprintf(csv, "engine,threads,topology,workload,rows,cols,density,generations,cell_updates_per_s,"
+                 "median_gen_ns,p99_gen_ns\n");
+    fprintf(json, "{\n  \"repeats\": %d,\n  \"run_seconds\": %.3f,\n  \"results\": [\n",
+            BENCH_REPEATS, BENCH_RUN_SECONDS);
+    for (int i = 0; i < count; i++) {
+        const bench_result* r = &res[i];
+        fprintf(csv, "%s,%d,%s,%s,%d,%d,%.2f,%ld,%.6e,%.0f,%.0f\n", r->engine, r->threads, r->wrap ? "wrap" : "nowrap",
+                r->workload, r->row, r->col, r->density, r->gens, r->updates, r->median * 1e9, r->p99 * 1e9);
+        fprintf(json, "    {\"engine\": \"%s\", \"threads\": %d, \"topology\": \"%s\", \"workload\": \"%s\", "
+                      "\"rows\": %d, \"cols\": %d, \"density\": %.2f, \"generations\": %ld, "
+                      "\"cell_updates_per_s\": %.6e, \"median_gen_ns\": %.0f, \"p99_gen_ns\": %.0f}%s\n",
+                r->engine, r->threads, r->wrap ? "wrap" : "nowrap", r->workload, r->row, r->col, r->density, r->gens,
+                r->updates, r->median * 1e9, r->p99 * 1e9, i + 1 < count ? "," : "");
+    }
+    fprintf(json, "  ]\n}\n");
+    fclose(csv);
+    fclose(json);
+}
+
+int main(int argc, char** argv) {
+    const char* prefix = "bench";
+    int quick = 0;
+    long maxThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < argc; i++) {
+        char* end = "";
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "-q") == 0) {
+            quick = 1;
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            maxThreads = strtol(argv[++i], &end, 10);
+        }
+        else {
+            end = "?";
+        }
+        if (*end != '\0' || maxThreads < 1) {
+            printf("usage: %s [-o prefix] [-q] [-t max_threads]\n", argv[0]);
+            return -1;
+        }
+    }
+    maxThreads = maxThreads < 1 ? 1 : maxThreads > BENCH_MAX_THREADS ? BENCH_MAX_THREADS : maxThreads;
+    // 1, 2, 4, ... below the limit, then the limit itself
+    int threadCounts[BENCH_MAX_THREADS];
+    int nthreads = 0;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        threadCounts[nthreads++] = t;
+    }
+    threadCounts[nthreads++] = maxThreads;
+    int nengines = sizeof(benchEngines) / sizeof(benchEngines[0]);
+    int nsizes = quick ? 2 : sizeof(benchSizes) / sizeof(benchSizes[0]);
+    int ndensities = sizeof(benchDensities) / sizeof(benchDensities[0]);
+    int npatterns = sizeof(benchPatterns) / sizeof(benchPatterns[0]);
+
+    int cap = nengines * nthreads * 2 * (nsizes * ndensities + npatterns);
+    bench_result* res = calloc(cap, sizeof(bench_result));
+    int count = 0;
+
+    // random boards, then the bundled patterns
+    for (int w = 0; w < nsizes * ndensities + npatterns; w++) {
+        gol_board* start;
+        const char* workload = "random";
+        double density = -1;
+        if (w < nsizes * ndensities) {
+            density = benchDensities[w % ndensities];
+            start = random_board(benchSizes[w / ndensities], density);
+        }
+        else {
+            int row, col;
+            long iter;
+            workload = benchPatterns[w - nsizes * ndensities];
+            start = read_file((char*)workload, NULL, &row, &col, &iter);
+        }
+        for (int e = 0; e < nengines; e++) {
+            for (int t = 0; t < nthreads; t++) {
+                for (int wrap = 1; wrap >= 0; wrap--) {
+                    bench_result* r = &res[count];
+                    if (bench_case(benchEngines[e], threadCounts[t], start, wrap, r) != 0) {
+                        continue;
+                    }
+                    snprintf(r->workload, sizeof(r->workload), "%s", workload);
+                    r->density = density;
+                    printf("%-10s -t %-3d %-6s %-15s %5dx%-5d %5.2f %.2e cell updates/s, median %.0f ns, p99 %.0f ns\n",
+                           r->engine, r->threads, wrap ? "wrap" : "nowrap", r->workload, r->row, r->col, r->density,
+                           r->updates, r->median * 1e9, r->p99 * 1e9);
+                    fflush(stdout);
+                    count++;
+                }
+            }
+        }
+        free_array(&start);
+    }
+
+    write_reports(prefix, res, count);
+    printf("%d cases written to %s.csv and %s.json\n", count, prefix, prefix);
+    free(res);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_board.h
+ * The board type shared by every part of the program. Cells are stored one bit each
+ * in a single contiguous, cache line aligned buffer. Every row starts on a cache line
+ * boundary and bits past the last column are always kept at 0 so whole words can be
+ * read and written without masking. One extra row past the last is allocated and never
+ * written, so kernels can point at it whenever they need a row of dead cells.
+ */
+#ifndef GOL_BOARD_H
+#define GOL_BOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// alignment in bytes of the cell buffer and of every row within it
+#define GOL_ALIGN 64
+// number of cells packed into one word of a row
+#define GOL_WORD_BITS 64
+
+#ifdef GOL_STATS
+// births and deaths in one row during the step that wrote it (see gol_stats.c)
+typedef struct gol_counts {
+    uint32_t births;
+    uint32_t deaths;
+} gol_counts;
+#endif
+
+typedef struct gol_board {
+    int row;            // number of rows
+    int col;            // number of cols
+    int words;          // number of words holding the cells of one row
+    int stride;         // words per row including padding up to GOL_ALIGN
+    uint64_t* cells;    // row r starts at cells + r * stride, row 'row' is all 0's
+    size_t bytes;       // size of the cell buffer, can be more than the board uses (see reuse_board)
+    void* map;          // mapped snapshot the cells live in (see gol_ckpt.c), NULL if allocated
+    size_t mapBytes;    // length of that mapping
+    void* arena;        // gol_arena the board and its cells were carved from (see gol_arena.c), NULL if allocated
+    uint64_t* hashes;   // row_hash of every row, filled by step_rows when writing this board, NULL = not hashed
+#ifdef GOL_STATS
+    gol_counts* counts; // filled per row by step_rows when writing this board, NULL = not counted
+#endif
+} gol_board;
+
+/* board_row(const gol_board*, int);
+ * @return: pointer to the first word of row r
+ */
+static inline uint64_t* board_row(const gol_board* b, int r) {
+    return b->cells + (size_t)r * b->stride;
+}
+
+/* row_hash(const uint64_t*, int, int);
+ * Hashes the cells of row r. The row number is mixed in so equal rows in different
+ * places hash differently, and the hashes of all rows add up to the board's hash.
+ * @return: 64 bit hash of the row
+ */
+static inline uint64_t row_hash(const uint64_t* cells, int words, int r) {
+    uint64_t h = (uint64_t)(r + 1) * 0x9E3779B97F4A7C15ULL;
+    for (int w = 0; w < words; w++) {
+        h = (h ^ cells[w]) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+/* get_cell(const gol_board*, int, int);
+ * @return: 1 if the cell at r, c is alive, 0 if it is dead
+ */
+static inline int get_cell(const gol_board* b, int r, int c) {
+    return (board_row(b, r)[c / GOL_WORD_BITS] >> (c % GOL_WORD_BITS)) & 1;
+}
+
+/* set_cell(gol_board*, int, int, int);
+ * Store val (0 or 1) as the state of the cell at r, c
+ */
+static inline void set_cell(gol_board* b, int r, int c, int val) {
+    uint64_t* word = board_row(b, r) + c / GOL_WORD_BITS;
+    uint64_t bit = (uint64_t)1 << (c % GOL_WORD_BITS);
+    *word = (*word & ~bit) | (val ? bit : 0);
+}
+
+#endif
@@ -0,0 +1,281 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_ckpt.c
+ * This file saves and restores snapshots of a running simulation. A snapshot is a
+ * CKPT_HEADER byte header (size, topology, generation) followed by the packed cells
+ * exactly as they sit in a gol_board, dead row included. The stepping loop only copies
+ * the board into one of two buffers; a writer thread puts it on disk, so the loop never
+ * waits for the file system. A snapshot is written to a temporary file and renamed over
+ * the last one, so a crash mid write leaves the previous snapshot intact.
+ * Resuming maps the file and uses the cells in place (copy on write) as the board.
+ * Snapshots use the byte order of the machine that wrote them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gol_ckpt.h"
+#include "gol_rule.h"
+
+_Static_assert(sizeof(ckpt_header) == CKPT_HEADER, "snapshot header must be CKPT_HEADER bytes");
+
+/* write_all(int, const void*, size_t);
+ * write() until every byte is out.
+ * @return: 0 on success, -1 on an error
+ */
+static int write_all(int fd, const void* data, size_t bytes) {
+    const char* p = data;
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0) {
+            return -1;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+/* write_snapshot(gol_ckpt*, int);
+ * Writes buffer b to the temporary file, flushes it to disk and renames it over the
+ * snapshot. Runs on the writer thread only.
+ * @return: 0 on success, -1 if the snapshot could not be written
+ */
+static int write_snapshot(gol_ckpt* ck, int b) {
+    ckpt_header head = ck->head;
+    head.generation = ck->gen[b];
+
+    int fd = open(ck->tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    int status = write_all(fd, &head, sizeof(head));
+    if (status == 0) {
+        status = write_all(fd, ck->buf[b], ck->bytes);
+    }
+    if (status == 0) {
+        status = fdatasync(fd);
+    }
+    close(fd);
+    if (status == 0) {
+        status = rename(ck->tmp, ck->path);
+    }
+    return status;
+}
+
+/* ckpt_writer(void*);
+ * Body of the writer thread. Waits for a pending buffer, writes it, and repeats until
+ * the checkpointer is freed. A pending buffer is always written before quitting.
+ * @param arg: the gol_ckpt
+ */
+static void* ckpt_writer(void* arg) {
+    gol_ckpt* ck = arg;
+
+    pthread_mutex_lock(&ck->lock);
+    while (1) {
+        while (ck->pending < 0 && !ck->quit) {
+            pthread_cond_wait(&ck->wake, &ck->lock);
+        }
+        if (ck->pending < 0) {
+            break;
+        }
+        ck->writing = ck->pending;
+        ck->pending = -1;
+        pthread_mutex_unlock(&ck->lock);
+
+        int status = write_snapshot(ck, ck->writing);
+        if (status != 0) {
+            printf("error: unable to write checkpoint '%s', the run continues\n", ck->path);
+        }
+
+        pthread_mutex_lock(&ck->lock);
+        ck->written += (status == 0);
+        ck->writing = -1;
+    }
+    pthread_mutex_unlock(&ck->lock);
+    return NULL;
+}
+
+/* create_ckpt(const gol_board*, int, long, char*);
+ * Create ckpt allocates both snapshot buffers for a board of this size and starts the
+ * writer thread. Snapshots go to <filename>.ckpt.
+ * @param board: board that will be saved (only its size is used here)
+ * @param wrap: 1 wrap, 0 nowrap
+ * @param total: generation the run stops at
+ * @param filename: the input file the snapshot is named after
+ * @return: the running checkpointer
+ */
+gol_ckpt* create_ckpt(const gol_board* board, int wrap, long total, char* filename) {
+    gol_ckpt* ck = calloc(1, sizeof(gol_ckpt));
+    ck->path = malloc(strlen(filename) + 6);
+    ck->tmp = malloc(strlen(filename) + 10);
+    sprintf(ck->path, "%s.ckpt", filename);
+    sprintf(ck->tmp, "%s.ckpt.tmp", filename);
+
+    memcpy(ck->head.magic, CKPT_MAGIC, sizeof(ck->head.magic));
+    ck->head.version = CKPT_VERSION;
+    ck->head.wrap = wrap;
+    ck->head.row = board->row;
+    ck->head.col = board->col;
+    ck->head.words = board->words;
+    ck->head.stride = board->stride;
+    ck->head.total = total;
+    ck->head.born = golRule.born;
+    ck->head.survive = golRule.survive;
+
+    // the dead row is saved too (always 0's) so a mapped snapshot is a complete board
+    ck->bytes = (size_t)(board->row + 1) * board->stride * sizeof(uint64_t);
+    for (int b = 0; b < 2; b++) {
+        ck->buf[b] = calloc(1, ck->bytes);
+        if (ck->buf[b] == NULL) {
+            printf("error: unable to allocate checkpoint buffers for a %dx%d board\n", board->row, board->col);
+            exit(-1);
+        }
+    }
+    ck->pending = -1;
+    ck->writing = -1;
+    pthread_mutex_init(&ck->lock, NULL);
+    pthread_cond_init(&ck->wake, NULL);
+    if (pthread_create(&ck->thread, NULL, ckpt_writer, ck) != 0) {
+        printf("error: unable to start the checkpoint writer\n");
+        exit(-1);
+    }
+    return ck;
+}
+
+/* ckpt_save(gol_ckpt*, const gol_board*, long);
+ * Copies the board into the buffer the writer is not using and hands it over. If the
+ * writer is still busy with the other buffer, an older snapshot still waiting is
+ * replaced by this one (counted in dropped), so the loop never blocks on the disk.
+ * @param ck: the checkpointer
+ * @param board: board to save
+ * @param gen: generation the board is at
+ */
+void ckpt_save(gol_ckpt* ck, const gol_board* board, long gen) {
+    pthread_mutex_lock(&ck->lock);
+    int b = (ck->writing == 0) ? 1 : 0;
+    // the buffer about to be filled can't also be handed out while it is filled
+    if (ck->pending >= 0) {
+        ck->dropped++;
+        ck->pending = -1;
+    }
+    pthread_mutex_unlock(&ck->lock);
+
+    memcpy(ck->buf[b], board->cells, (size_t)board->row * board->stride * sizeof(uint64_t));
+    ck->gen[b] = gen;
+
+    pthread_mutex_lock(&ck->lock);
+    ck->pending = b;
+    pthread_cond_signal(&ck->wake);
+    pthread_mutex_unlock(&ck->lock);
+}
+
+/* ckpt_finish(gol_ckpt*);
+ * Waits for the last pending snapshot to be written and stops the writer, after which
+ * written and dropped are final. Nothing can be saved afterwards.
+ * @param ck: the checkpointer
+ */
+void ckpt_finish(gol_ckpt* ck) {
+    if (ck->finished) {
+        return;
+    }
+    pthread_mutex_lock(&ck->lock);
+    ck->quit = 1;
+    pthread_cond_signal(&ck->wake);
+    pthread_mutex_unlock(&ck->lock);
+    pthread_join(ck->thread, NULL);
+    ck->finished = 1;
+}
+
+/* free_ckpt(gol_ckpt**);
+ * Stops the writer (see ckpt_finish) if it is still running and frees the buffers.
+ * The caller's pointer is set to NULL.
+ * @param pck: pointer to the gol_ckpt*
+ */
+void free_ckpt(gol_ckpt** pck) {
+    gol_ckpt* ck = *pck;
+    ckpt_finish(ck);
+
+    pthread_mutex_destroy(&ck->lock);
+    pthread_cond_destroy(&ck->wake);
+    free(ck->buf[0]);
+    free(ck->buf[1]);
+    free(ck->path);
+    free(ck->tmp);
+    free(ck);
+    *pck = NULL;
+}
+
+/* load_snapshot(char*, int, long*, long*);
+ * Maps a snapshot file and returns a board whose cells point straight into the
+ * mapping, nothing is copied. The mapping is private, so stepping the board never
+ * changes the file (free_array unmaps it). The header is checked against the layout
+ * this build uses and against the topology asked for on the command line.
+ * @param filename: the snapshot file
+ * @param wrap: 1 wrap, 0 nowrap, from the command line
+ * @param pgen: pointer to the long storing the generation of the snapshot
+ * @param ptotal: pointer to the long storing the generation the run stops at
+ * @return: the board held in the snapshot
+ */
+gol_board* load_snapshot(char* filename, int wrap, long* pgen, long* ptotal) {
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        printf("error: '%s' is an invalid snapshot file\n\n", filename);
+        exit(-1);
+    }
+    if ((size_t)info.st_size < sizeof(ckpt_header)) {
+        printf("error: '%s' is too short to be a snapshot\n\n", filename);
+        exit(-1);
+    }
+    char* map = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("error: unable to map '%s'\n\n", filename);
+        exit(-1);
+    }
+
+    const ckpt_header* head = (const ckpt_header*)map;
+    if (memcmp(head->magic, CKPT_MAGIC, sizeof(head->magic)) != 0 || head->version != CKPT_VERSION) {
+        printf("error: '%s' is not a version %d snapshot\n\n", filename, CKPT_VERSION);
+        exit(-1);
+    }
+    // the same size board must come out of create_empty_board, with the same layout
+    int words = (head->col + GOL_WORD_BITS - 1) / GOL_WORD_BITS;
+    int lineWords = GOL_ALIGN / sizeof(uint64_t);
+    int stride = (words + lineWords - 1) / lineWords * lineWords;
+    size_t bytes = (size_t)(head->row + 1) * stride * sizeof(uint64_t);
+    if (head->row < 1 || head->col < 1 || head->words != words || head->stride != stride ||
+        (size_t)info.st_size != sizeof(ckpt_header) + bytes ||
+        head->generation < 0 || head->generation > head->total) {
+        printf("error: '%s' is a damaged snapshot\n\n", filename);
+        exit(-1);
+    }
+    if (head->wrap != wrap) {
+        printf("error: '%s' was saved from a %s run\n\n", filename, head->wrap ? "wrap" : "nowrap");
+        exit(-1);
+    }
+    if (head->born != golRule.born || head->survive != golRule.survive) {
+        printf("error: '%s' was saved from a run with another rule, give the same -r\n\n", filename);
+        exit(-1);
+    }
+
+    gol_board* board = malloc(sizeof(gol_board));
+    board->row = head->row;
+    board->col = head->col;
+    board->words = words;
+    board->stride = stride;
+    board->cells = (uint64_t*)(map + sizeof(ckpt_header));
+    board->bytes = bytes;
+    board->map = map;
+    board->mapBytes = info.st_size;
+    board->arena = NULL;
+    board->hashes = NULL;
+#ifdef GOL_STATS
+    board->counts = NULL;
+#endif
+    *pgen = head->generation;
+    *ptotal = head->total;
+    return board;
+}
@@ -0,0 +1,51 @@
+#ifndef GOL_CKPT_H
+#define GOL_CKPT_H
+
+#include <pthread.h>
+#include "gol_board.h"
+
+// first bytes of every snapshot file, and the layout version that follows them
+#define CKPT_MAGIC "GOLSNAP"
+#define CKPT_VERSION 2
+// the header is padded to GOL_ALIGN bytes so mapped cells keep their alignment
+#define CKPT_HEADER GOL_ALIGN
+
+// fixed size header at the start of a snapshot, the packed cells follow it
+typedef struct ckpt_header {
+    char magic[8];          // CKPT_MAGIC
+    uint32_t version;       // CKPT_VERSION
+    int32_t wrap;           // topology the board was stepped with, 1 wrap, 0 nowrap
+    int32_t row, col;       // board size
+    int32_t words, stride;  // layout of a row, see gol_board.h
+    int64_t generation;     // generation the cells are at
+    int64_t total;          // generation the run stops at
+    uint16_t born, survive; // rule the board was stepped with, see gol_rule.h
+    uint8_t unused[CKPT_HEADER - 52];
+} ckpt_header;
+
+// background writer for periodic snapshots of one board
+typedef struct gol_ckpt {
+    char* path;             // snapshot file
+    char* tmp;              // written first, then renamed over path
+    ckpt_header head;
+    size_t bytes;           // cell bytes in a snapshot, including the dead row
+    uint64_t* buf[2];       // one buffer is filled while the other is written
+    long gen[2];            // generation held in each buffer
+    int pending;            // buffer waiting for the writer, -1 for none
+    int writing;            // buffer the writer is writing, -1 for none
+    int quit;
+    int finished;           // writer has been stopped and joined
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    long written;           // snapshots on disk
+    long dropped;           // snapshots replaced by a newer one before being written
+} gol_ckpt;
+
+gol_ckpt* create_ckpt(const gol_board*, int, long, char*);
+void ckpt_save(gol_ckpt*, const gol_board*, long);
+void ckpt_finish(gol_ckpt*);
+void free_ckpt(gol_ckpt**);
+gol_board* load_snapshot(char*, int, long*, long*);
+
+#endif
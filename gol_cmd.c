@@ -8,32 +8,72 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "gol_cmd.h"
 
-/* parse_cmd(int, char**, char**, int*, int*, int*);
+/* default_opts(gol_opts*);
+ * Sets everything that can be changed with an option to its default.
+ */
+static void default_opts(gol_opts* opts) {
+    opts->engine = ENGINE_AUTO;
+    opts->threads = 1;
+    opts->procs = 1;
+    opts->tile_k = 1;
+    opts->tile_rows = 256;
+    opts->tile_cols = 8192;
+    opts->hash_mb = 1024;
+    opts->iterations = -1;
+    opts->ckpt_every = 0;
+    opts->resume = NULL;
+    opts->start_gen = 0;
+    opts->stats = NULL;
+    opts->batch = NULL;
+    opts->output = NULL;
+    opts->export_every = 0;
+    opts->replay = NULL;
+    parse_rule("B3/S23", &opts->rule);
+}
+
+/* parse_cmd(int, char**, gol_opts*);
  * Parse command line function takes in the argv/argc values from user input, and acts
  * as a hub function to error check all the input, and return all the data to main (by pointer)
+ * The three or four positional parameters come first, followed by any options (which all
+ * start with '-', see check_flags).
  * @param argv: the number of arguments given in the command line 
  * @param argc: the array of strings containing all of the text given in the command line
- * @param infile: a pointer to a string that will point to user input file string
- * @param pwrap: int pointer to return wrap code value to main
- * @param pshow: int pointer to return show code value to main
- * @param pspeed: int pointer to return speed code value to main
+ * @param opts: struct that all of the user's choices are returned in
  * @return: 0 if all input was sucessful, -1 if any portion of error checking failed
  */
-int parse_cmd(int argv, char** argc, char** infile, int* pwrap, int* pshow, int* pspeed) {
+int parse_cmd(int argv, char** argc, gol_opts* opts) {
     // for formatting
     printf("\n");
 
+    // a manifest of many boards takes its own parameters, and so does a replay
+    if (argv > 1 && strcmp(argc[1], "--batch") == 0) {
+        return parse_batch(argv, argc, opts);
+    }
+    if (argv > 1 && strcmp(argc[1], "--replay") == 0) {
+        return parse_replay(argv, argc, opts);
+    }
+
+    // count the positional parameters, options start at the first '-'
+    int npos = 1;
+    while (npos < argv && argc[npos][0] != '-') {
+        npos++;
+    }
+
     // Ensure all options are entered into command line
-    if (argv < 4 || argv > 5) {
-        printf("error: %d parameters received\nexpected -> three or four\n\n", argv - 1);
+    if (npos < 4 || npos > 5) {
+        printf("error: %d parameters received\nexpected -> three or four\n\n", npos - 1);
         return -1;
     }
 
     // set infile to expected file name from cmd line input
-    *infile = argc[1];
-    int validFileFLag = check_file(*infile);
+    opts->filename = argc[1];
+    int validFileFLag = check_file(opts->filename);
     
     // check that string in the wrap/nowrap input field is valid
     int wrapVal = check_wrap(argc[2]);
@@ -43,52 +83,169 @@ int parse_cmd(int argv, char** argc, char** infile, int* pwrap, int* pshow, int*
     int showVal = check_show(argc[3]);
 
     // error check if show was called without speed param
-    if (showVal == 1 && argv == 4){
+    if (showVal == 1 && npos == 4){
         printf("error: no speed paramter was provided\n\n");
         speedVal = -1;
     }
     // if a speed param was given in cmd line
-    if (argv == 5) {
+    if (npos == 5) {
         speedVal = check_speed(argc[4], showVal);
     }
+
+    default_opts(opts);
+    int flagVal = check_flags(argv, argc, npos, opts);
+
+    // hashlife steps a torus, see gol_hash.c
+    if (flagVal == 0 && opts->engine == ENGINE_HASHLIFE && wrapVal != 1) {
+        printf("error: the hashlife engine only runs wrapped boards\n\n");
+        flagVal = -1;
+    }
+    // the unbounded plane has its own chunked engine, see gol_inf.c
+    if (flagVal == 0 && wrapVal == WRAP_INFINITE) {
+        if (opts->engine != ENGINE_AUTO || opts->threads > 1 || opts->procs > 1 || opts->tile_k > 1) {
+            printf("error: infinite runs its own engine and does not take -e, -t, -p or -k\n\n");
+            flagVal = -1;
+        }
+        // its cells live in chunks, not in the board a snapshot holds
+        if (opts->ckpt_every > 0 || opts->resume != NULL || opts->export_every > 0) {
+            printf("error: infinite runs can not be checkpointed, resumed or exported\n\n");
+            flagVal = -1;
+        }
+        if (opts->stats != NULL) {
+            printf("error: infinite runs do not record --stats\n\n");
+            flagVal = -1;
+        }
+        // with B0 the whole unbounded plane would come alive
+        if (opts->rule.born & 1) {
+            printf("error: infinite can not run a rule with B0\n\n");
+            flagVal = -1;
+        }
+        opts->engine = ENGINE_INFINITE;
+    }
+
+    // workers only hand back the final board
+    if (flagVal == 0 && opts->procs > 1 && showVal == 1) {
+        printf("error: -p runs can not be shown\n\n");
+        flagVal = -1;
+    }
+
     // if any of the return flags are -1, exit
-    if (validFileFLag == -1 || wrapVal == -1 || showVal == -1 || speedVal == -1) {
+    if (validFileFLag == -1 || wrapVal == -1 || showVal == -1 || speedVal == -1 || flagVal == -1) {
         exit(-1);
     }
     else {
         // assign vals to pointers to return them "by reference"
-        *pwrap = wrapVal;
-        *pshow = showVal;
-        *pspeed = speedVal;   
+        opts->wrap = wrapVal;
+        opts->show = showVal;
+        opts->speed = speedVal;   
     }
 
     // return 0 if input was valid
     return 0;
 }
 
+/* parse_batch(int, char**, gol_opts*);
+ * Parse batch checks the command line of a batch run:
+ *   --batch <manifest> <wrap|nowrap> [options]
+ * The manifest lists one pattern file per line (see gol_batch.c). Boards are never
+ * shown, -t is the number of boards run at once, and -o names the file the summary
+ * lines go to. Options that only make sense for one board are turned down.
+ * @param argv: the number of arguments given in the command line
+ * @param argc: the array of strings containing all of the text given in the command line
+ * @param opts: struct that all of the user's choices are returned in
+ * @return: 0 if all input was sucessful, -1 if any portion of error checking failed
+ */
+int parse_batch(int argv, char** argc, gol_opts* opts) {
+    if (argv < 4 || argc[2][0] == '-' || argc[3][0] == '-') {
+        printf("error: batch mode expects -> --batch <manifest> <wrap|nowrap> [options]\n\n");
+        return -1;
+    }
+    default_opts(opts);
+    opts->batch = argc[2];
+    opts->filename = argc[2];
+    opts->show = 0;
+    opts->speed = 0;
+    int validFileFLag = check_file(opts->batch);
+    int wrapVal = check_wrap(argc[3]);
+    int flagVal = check_flags(argv, argc, 4, opts);
+
+    // every board is stepped whole on its own thread, no engine with its own state
+    if (flagVal == 0 && (opts->engine == ENGINE_HASHLIFE || opts->engine == ENGINE_SPARSE || opts->tile_k > 1)) {
+        printf("error: batch mode runs the auto, scalar, swar, avx2 and avx512 engines without -k\n\n");
+        flagVal = -1;
+    }
+    if (flagVal == 0 && (opts->ckpt_every > 0 || opts->resume != NULL || opts->stats != NULL || opts->procs > 1 ||
+                         opts->export_every > 0)) {
+        printf("error: batch mode does not take --checkpoint-every, --resume, --export-every, --stats or -p\n\n");
+        flagVal = -1;
+    }
+    if (wrapVal == WRAP_INFINITE) {
+        printf("error: batch mode runs wrap and nowrap boards\n\n");
+        wrapVal = -1;
+    }
+    if (validFileFLag == -1 || wrapVal == -1 || flagVal == -1) {
+        exit(-1);
+    }
+    opts->wrap = wrapVal;
+    return 0;
+}
+
+/* parse_replay(int, char**, gol_opts*);
+ * Parse replay checks the command line that plays back a frame file written with
+ * --export-every (see gol_export.c):
+ *   --replay <frames> <show|hide> [slow|med|fast]
+ * @param argv: the number of arguments given in the command line
+ * @param argc: the array of strings containing all of the text given in the command line
+ * @param opts: struct that all of the user's choices are returned in
+ * @return: 0 if all input was sucessful, -1 if any portion of error checking failed
+ */
+int parse_replay(int argv, char** argc, gol_opts* opts) {
+    if (argv < 4 || argv > 5) {
+        printf("error: replay expects -> --replay <frames> <show|hide> [slow|med|fast]\n\n");
+        return -1;
+    }
+    default_opts(opts);
+    opts->replay = argc[2];
+    opts->filename = argc[2];
+    int validFileFLag = check_file(opts->replay);
+    int showVal = check_show(argc[3]);
+    int speedVal = 0;
+    if (showVal == 1 && argv == 4) {
+        printf("error: no speed paramter was provided\n\n");
+        speedVal = -1;
+    }
+    if (argv == 5) {
+        speedVal = check_speed(argc[4], showVal);
+    }
+    if (validFileFLag == -1 || showVal == -1 || speedVal == -1) {
+        exit(-1);
+    }
+    opts->show = showVal;
+    opts->speed = speedVal;
+    return 0;
+}
+
 /* check_file(char*);
  * This function checks that the cmd line input for the file name is inputted
- * correctly by the user. A file pointer is initialized, and if not valid, 
- * the program prints and error and returns the error flag value of -1. If
- * the file name is valid, the program continues
+ * correctly by the user. The file is only looked up here (it is opened once, by
+ * read_file), and if it is missing or not a regular file the program prints an
+ * error and returns the error flag value of -1. If the file name is valid, the
+ * program continues
  * @param filename: string containing the user input file name
- * @return returnVal: 0 for succesful file opening, -1 for failure
+ * @return returnVal: 0 for a readable file, -1 for failure
 */
 int check_file(char* filename) {
     // int for return flag
     int returnVal = 0;
 
-    // open file to read
-    FILE* infile = fopen(filename, "r");
-    // check if file pointer is null (indicating invalid file)
-    if (infile == NULL) {
+    // look the file up without opening it
+    struct stat info;
+    if (stat(filename, &info) != 0 || !S_ISREG(info.st_mode) || access(filename, R_OK) != 0) {
         printf("error: '%s' is an invalid file\n", filename);
         printf("ensure file exists and entered correctly\n\n");
         returnVal = -1;
         exit(-1);
     }
-    // close file pointer
-    fclose(infile);
 
     // return success/failure flag
     return returnVal;
@@ -96,7 +253,7 @@ int check_file(char* filename) {
 
 /* check_wrap(char*);
  * Check wrap reads the commnand line argument dictating wrap/nowrap for the game.
- * wrap = 1, nowrap = 0, failure = -1
+ * wrap = 1, nowrap = 0, infinite = WRAP_INFINITE (no edge at all), failure = -1
  * @param wrapString: string containing user input string for wrapping value
  * @return wrapVal: indicated wrap/nowrap or error value of -1
 */
@@ -111,10 +268,14 @@ int check_wrap(char* wrapString) {
     else if (strcmp(wrapString, "nowrap") == 0) {
         wrapVal = 0;
     }
+    // else if string was infinite, the board is a window onto an unbounded plane
+    else if (strcmp(wrapString, "infinite") == 0) {
+        wrapVal = WRAP_INFINITE;
+    }
     // else invalid, print invalid input message
     else {
         printf("error: '%s' is not a valid 'wrap' parameter\n", wrapString);
-        printf("enter -> (wrap/nowrap)\n\n");
+        printf("enter -> (wrap/nowrap/infinite)\n\n");
         wrapVal = -1;
         exit(-1);
     }
@@ -192,4 +353,229 @@ int check_speed(char* speedString, int showVal) {
     }
     // return back the speed val code
     return speedVal;
+}
+
+/* check_flags(int, char**, int, gol_opts*);
+ * Check flags reads every option after the positional parameters. Each option is a
+ * name starting with '-' followed by its value.
+ *   -e <auto|scalar|swar|avx2|avx512|hashlife|sparse>   engine used to step the board (default auto)
+ *   -t <N>                              number of threads to step with (default 1)
+ *   -p <N>                              number of worker processes to split the board across (default 1)
+ *   -k <K>                              generations per tile pass, turns on tiling (default 1)
+ *   -T <R>x<C>                          tile size in cells for -k (default 256x8192)
+ *   -m <MB>                             memory cap of the hashlife node store (default 1024)
+ *   -n <N>                              generations to run, overrides the count in the file
+ *   -o <file>                           file for the summary lines of a batch run (batch only)
+ *   -r <rule>                           rule in B/S notation or by name (default B3/S23)
+ *   --checkpoint-every <N>              save a snapshot every N generations
+ *   --resume <snapshot>                 continue from a snapshot instead of the config file
+ *   --export-every <N>                  add every Nth generation to <config_file>.frames
+ *   --stats <file>                      per generation stats (make STATS=1 builds only)
+ * @param argv: the number of arguments given in the command line
+ * @param argc: the array of strings containing all of the text given in the command line
+ * @param start: index of the first option in argc
+ * @param opts: struct the options are stored in
+ * @return: 0 if every option was valid, -1 otherwise
+ */
+int check_flags(int argv, char** argc, int start, gol_opts* opts) {
+    for (int i = start; i < argv; i += 2) {
+        // every option takes a value
+        if (i + 1 >= argv) {
+            printf("error: option '%s' is missing its value\n\n", argc[i]);
+            return -1;
+        }
+        if (strcmp(argc[i], "-e") == 0) {
+            opts->engine = check_engine(argc[i+1]);
+        }
+        else if (strcmp(argc[i], "-t") == 0) {
+            opts->threads = check_positive(argc[i+1], "number of threads");
+        }
+        else if (strcmp(argc[i], "-p") == 0) {
+            opts->procs = check_positive(argc[i+1], "number of processes");
+        }
+        else if (strcmp(argc[i], "-k") == 0) {
+            opts->tile_k = check_positive(argc[i+1], "number of generations per tile");
+        }
+        else if (strcmp(argc[i], "-T") == 0) {
+            opts->tile_rows = check_tile(argc[i+1], &opts->tile_rows, &opts->tile_cols);
+        }
+        else if (strcmp(argc[i], "-m") == 0) {
+            opts->hash_mb = check_positive(argc[i+1], "memory cap");
+        }
+        else if (strcmp(argc[i], "-n") == 0) {
+            opts->iterations = check_iterations(argc[i+1]);
+            if (opts->iterations == -1) {
+                return -1;
+            }
+        }
+        else if (strcmp(argc[i], "--checkpoint-every") == 0) {
+            opts->ckpt_every = check_positive(argc[i+1], "checkpoint interval");
+        }
+        else if (strcmp(argc[i], "--export-every") == 0) {
+            opts->export_every = check_positive(argc[i+1], "export interval");
+        }
+        else if (strcmp(argc[i], "--resume") == 0) {
+            opts->resume = argc[i+1];
+        }
+        else if (strcmp(argc[i], "-r") == 0) {
+            if (parse_rule(argc[i+1], &opts->rule) != 0) {
+                printf("error: '%s' is not a valid rule\n", argc[i+1]);
+                printf("enter -> B<counts>/S<counts> like B36/S23, or a name like highlife\n\n");
+                return -1;
+            }
+        }
+        else if (strcmp(argc[i], "-o") == 0 && opts->batch != NULL) {
+            opts->output = argc[i+1];
+        }
+        else if (strcmp(argc[i], "--stats") == 0) {
+#ifdef GOL_STATS
+            opts->stats = argc[i+1];
+#else
+            // the counting lives in the kernels, so it is left out of a normal build
+            printf("error: --stats needs a build with stats, rebuild with make clean && make STATS=1\n\n");
+            return -1;
+#endif
+        }
+        else {
+            printf("error: '%s' is not a valid option\n", argc[i]);
+            printf("enter -> (-e/-t/-p/-k/-T/-m/-n/-r/--checkpoint-every/--resume/--export-every/--stats)\n\n");
+            return -1;
+        }
+        if (opts->engine == -1 || opts->threads == -1 || opts->procs == -1 || opts->tile_k == -1 || opts->tile_rows == -1 ||
+            opts->hash_mb == -1 || opts->ckpt_every == -1 || opts->export_every == -1) {
+            return -1;
+        }
+    }
+    // tiles are stepped one at a time with a row kernel
+    if (opts->tile_k > 1 && (opts->engine == ENGINE_SCALAR || opts->threads > 1)) {
+        printf("error: -k runs on one thread and needs an engine other than scalar\n\n");
+        return -1;
+    }
+    // with B0 empty space comes alive, which hashlife's shared empty nodes can't hold
+    if (opts->engine == ENGINE_HASHLIFE && (opts->rule.born & 1)) {
+        printf("error: the hashlife engine can not run a rule with B0\n\n");
+        return -1;
+    }
+    // hashlife jumps the whole board at once, and only knows the wrapped (torus) board
+    if ((opts->engine == ENGINE_HASHLIFE || opts->engine == ENGINE_SPARSE) &&
+        (opts->threads > 1 || opts->tile_k > 1)) {
+        printf("error: the hashlife and sparse engines do not take -t or -k\n\n");
+        return -1;
+    }
+    // every worker process steps its band with a row kernel, on its own
+    if (opts->procs > 1 && (opts->engine == ENGINE_SCALAR || opts->engine == ENGINE_HASHLIFE ||
+                            opts->engine == ENGINE_SPARSE || opts->threads > 1 || opts->tile_k > 1)) {
+        printf("error: -p runs the auto, swar, avx2 and avx512 engines without -t or -k\n\n");
+        return -1;
+    }
+    // the board only comes together again at the end of the run
+    if (opts->procs > 1 && (opts->ckpt_every > 0 || opts->resume != NULL || opts->stats != NULL || opts->export_every > 0)) {
+        printf("error: -p does not take --checkpoint-every, --resume, --export-every or --stats\n\n");
+        return -1;
+    }
+    // the scalar reference steps the whole board in one call, it can't be split
+    // (in batch mode -t counts boards run at once, not threads per board)
+    if (opts->engine == ENGINE_SCALAR && opts->threads > 1 && opts->batch == NULL) {
+        printf("error: the scalar engine only runs on one thread\n\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* check_engine(char*);
+ * Check engine reads the name of the engine used to step the board.
+ * scalar = ENGINE_SCALAR (the one cell at a time reference), swar = ENGINE_SWAR,
+ * avx2 = ENGINE_AVX2, avx512 = ENGINE_AVX512, auto = ENGINE_AUTO (best this CPU runs),
+ * hashlife = ENGINE_HASHLIFE, sparse = ENGINE_SPARSE (only steps tiles with activity)
+ * @param engineString: string containing user input string for the engine
+ * @return engineVal: ENGINE_* code or -1 if the name is not known
+ */
+int check_engine(char* engineString) {
+    int engineVal;
+    if (strcmp(engineString, "scalar") == 0) {
+        engineVal = ENGINE_SCALAR;
+    }
+    else if (strcmp(engineString, "swar") == 0) {
+        engineVal = ENGINE_SWAR;
+    }
+    else if (strcmp(engineString, "avx2") == 0) {
+        engineVal = ENGINE_AVX2;
+    }
+    else if (strcmp(engineString, "avx512") == 0) {
+        engineVal = ENGINE_AVX512;
+    }
+    else if (strcmp(engineString, "auto") == 0) {
+        engineVal = ENGINE_AUTO;
+    }
+    else if (strcmp(engineString, "hashlife") == 0) {
+        engineVal = ENGINE_HASHLIFE;
+    }
+    else if (strcmp(engineString, "sparse") == 0) {
+        engineVal = ENGINE_SPARSE;
+    }
+    else {
+        printf("error: '%s' is not a valid engine\n", engineString);
+        printf("enter -> (auto/scalar/swar/avx2/avx512/hashlife/sparse)\n\n");
+        engineVal = -1;
+    }
+    return engineVal;
+}
+
+/* check_positive(char*, char*);
+ * Check positive reads an option value that has to be a number of 1 or more
+ * (a number of threads, generations, megabytes...). Like -n, the whole value must be
+ * the number, so "10x" is refused, and so is anything past INT_MAX.
+ * @param numString: string containing the user input number
+ * @param what: what the number is, for the error message
+ * @return numVal: the number (at least 1) or -1 if it is not a positive number
+ */
+int check_positive(char* numString, char* what) {
+    char* end;
+    errno = 0;
+    long numVal = strtol(numString, &end, 10);
+    if (errno != 0 || end == numString || *end != '\0' || numVal < 1 || numVal > INT_MAX) {
+        printf("error: '%s' is not a valid %s\n", numString, what);
+        printf("enter -> (a number of 1 or more)\n\n");
+        numVal = -1;
+    }
+    return (int)numVal;
+}
+
+/* check_iterations(char*);
+ * Reads the -n option, the number of generations to run. Needed for RLE and
+ * Life 1.06 files, which do not store one, and overrides the count in the file
+ * for the original format.
+ * @param numString: the value given after -n
+ * @return numVal: the number of iterations (0 or more), -1 if invalid
+ */
+long check_iterations(char* numString) {
+    char* end;
+    errno = 0;
+    long numVal = strtol(numString, &end, 10);
+    if (errno != 0 || end == numString || *end != '\0' || numVal < 0) {
+        printf("error: '%s' is not a valid number of iterations\n", numString);
+        printf("enter -> (a number of 0 or more)\n\n");
+        numVal = -1;
+    }
+    return numVal;
+}
+
+/* check_tile(char*, int*, int*);
+ * Check tile reads a tile size written as <rows>x<cols>, both positive.
+ * @param tileString: string containing user input tile size
+ * @param prows: where the number of rows is stored
+ * @param pcols: where the number of columns is stored
+ * @return: the number of rows, or -1 if the size is not valid
+ */
+int check_tile(char* tileString, int* prows, int* pcols) {
+    int rows, cols;
+    char extra;
+    if (sscanf(tileString, "%dx%d%c", &rows, &cols, &extra) != 2 || rows < 1 || cols < 1) {
+        printf("error: '%s' is not a valid tile size\n", tileString);
+        printf("enter -> (<rows>x<cols>, e.g. 256x8192)\n\n");
+        return -1;
+    }
+    *pcols = cols;
+    *prows = rows;
+    return rows;
 }
\ No newline at end of file
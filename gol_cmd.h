@@ -1,5 +1,57 @@
-int parse_cmd(int, char**, char**, int*, int*, int*);
+#ifndef GOL_CMD_H
+#define GOL_CMD_H
+
+#include "gol_rule.h"
+
+// engines that can be picked with -e
+#define ENGINE_SCALAR 0
+#define ENGINE_SWAR 1
+#define ENGINE_AVX2 2
+#define ENGINE_AVX512 3
+#define ENGINE_AUTO 4
+#define ENGINE_HASHLIFE 5
+#define ENGINE_SPARSE 6
+#define ENGINE_INFINITE 7
+
+// topologies (the wrap parameter): 0 = nowrap, 1 = wrap, and an unbounded plane
+#define WRAP_INFINITE 2
+
+// everything the user asked for on the command line
+typedef struct gol_opts {
+    char* filename;     // input file
+    int wrap;           // 1 = wrap, 0 = nowrap, WRAP_INFINITE = infinite
+    int show;           // 1 = show, 0 = hide
+    int speed;          // frames per second when showing
+    int engine;         // ENGINE_* used to step the board
+    int threads;        // number of threads stepping the board
+    int procs;          // -p, worker processes the board is split across, 1 = no workers (see gol_dist.c)
+    int tile_k;         // generations per tile pass, 1 = not tiled
+    int tile_rows;      // rows in a tile
+    int tile_cols;      // columns in a tile
+    int hash_mb;        // memory cap of the HashLife node store in megabytes
+    long iterations;    // generations to run, -1 = use the count in the file
+    int ckpt_every;     // generations between snapshots, 0 = no snapshots
+    char* resume;       // snapshot to continue from instead of the file, NULL = none
+    long start_gen;     // generation the board starts at, 0 unless resumed
+    char* stats;        // where per generation stats are streamed, NULL = off (see gol_stats.c)
+    char* batch;        // manifest of pattern files for a batch run, NULL = one board (see gol_batch.c)
+    char* output;       // -o, file the batch summary lines go to, NULL = stdout
+    int export_every;   // generations between exported frames, 0 = no export (see gol_export.c)
+    char* replay;       // frame file played back instead of running, NULL = run a board
+    gol_rule rule;      // -r, rule to step with (default B3/S23)
+} gol_opts;
+
+int parse_cmd(int, char**, gol_opts*);
+int parse_batch(int, char**, gol_opts*);
+int parse_replay(int, char**, gol_opts*);
 int check_file(char*);
 int check_wrap(char*);
 int check_show(char*);
-int check_speed(char*, int);
\ No newline at end of file
+int check_speed(char*, int);
+int check_flags(int, char**, int, gol_opts*);
+int check_engine(char*);
+int check_positive(char*, char*);
+long check_iterations(char*);
+int check_tile(char*, int*, int*);
+
+#endif
@@ -0,0 +1,165 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_cycle.c
+ * This file notices when the board has settled into a still life or a cycle, so the
+ * rest of the run can be skipped. Every generation gets a 64 bit hash: the engines
+ * hash each row as they write it (see step_rows, the sparse engine only rehashes rows
+ * that changed), and the board's hash is the sum of its row hashes. Hashes go into a small direct mapped table of the generation they
+ * were seen at. The first time a hash comes back, the board from p generations ago has
+ * returned, so the cycle started then and its period is p. Before trusting it the board
+ * is copied and stepped p more generations; if the copy comes back the cycle is real and
+ * the run can jump over every whole period left, otherwise it was a hash collision.
+ * A table slot keeps only the newest generation that landed in it, so a cycle longer
+ * than CYCLE_SLOTS may be found late or not at all, but never wrongly.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_cycle.h"
+#include "gol_io.h"
+#include "gol_sim.h"
+
+/* board_hash(const gol_cycle*, const gol_board*);
+ * Adds up the row hashes the engine left for the board.
+ * @return: hash of the whole board
+ */
+static uint64_t board_hash(const gol_cycle* cy, const gol_board* board) {
+    uint64_t h = 0;
+    for (int r = 0; r < board->row; r++) {
+        h += cy->hashes[r];
+    }
+    return h;
+}
+
+/* same_board(const gol_board*, const gol_board*);
+ * @return: 1 if every cell of the two boards is the same
+ */
+static int same_board(const gol_board* a, const gol_board* b) {
+    for (int r = 0; r < a->row; r++) {
+        if (memcmp(board_row(a, r), board_row(b, r), a->words * sizeof(uint64_t)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* create_cycle(gol_board*, gol_board*, long, gol_arena*);
+ * Create cycle allocates the history table and starts watching board (see cycle_reset).
+ * @param board: board at the start of the run
+ * @param flex: the other board the run swaps with
+ * @param gen: generation board is at
+ * @param arena: arena to carve the copy of a candidate board from, NULL to allocate it
+ * @return: the detector
+ */
+gol_cycle* create_cycle(gol_board* board, gol_board* flex, long gen, gol_arena* arena) {
+    gol_cycle* cy = calloc(1, sizeof(gol_cycle));
+    if (cy == NULL || (cy->table = malloc(CYCLE_SLOTS * sizeof(cycle_slot))) == NULL) {
+        printf("error: unable to allocate cycle detection\n");
+        exit(-1);
+    }
+    if (arena != NULL) {
+        cy->copy = arena_board(arena, board->row, board->col);
+    }
+    cycle_reset(cy, board, flex, gen);
+    return cy;
+}
+
+/* cycle_reset(gol_cycle*, gol_board*, gol_board*, long);
+ * Forgets everything seen so far and starts watching a new run. Both boards get the
+ * row hashes the kernels fill in (grown if the board has more rows than the last one),
+ * the copy of a candidate is sized for the board, so checking never allocates, and the
+ * starting board is hashed and recorded.
+ * @param cy: the detector
+ * @param board: board at the start of the run
+ * @param flex: the other board the run swaps with
+ * @param gen: generation board is at
+ */
+void cycle_reset(gol_cycle* cy, gol_board* board, gol_board* flex, long gen) {
+    if (board->row > cy->rows) {
+        free(cy->hashes);
+        cy->hashes = malloc(board->row * sizeof(uint64_t));
+        if (cy->hashes == NULL) {
+            printf("error: unable to allocate cycle detection for %d rows\n", board->row);
+            exit(-1);
+        }
+        cy->rows = board->row;
+    }
+    if (cy->copy == NULL || cy->copy->row != board->row || cy->copy->col != board->col) {
+        gol_board* copy = reuse_board(cy->copy, board->row, board->col);
+        if (cy->copy != NULL && copy != cy->copy) {
+            free_array(&cy->copy);
+        }
+        cy->copy = copy;
+    }
+    for (int s = 0; s < CYCLE_SLOTS; s++) {
+        cy->table[s].gen = -1;
+    }
+    cy->candGen = -1;
+    cy->start = -1;
+    cy->period = 0;
+    cy->collisions = 0;
+    board->hashes = cy->hashes;
+    flex->hashes = cy->hashes;
+
+    // the starting board is hashed here, every later one by the engine that wrote it
+    for (int r = 0; r < board->row; r++) {
+        cy->hashes[r] = row_hash(board_row(board, r), board->words, r);
+    }
+    uint64_t h = board_hash(cy, board);
+    cy->table[h & (CYCLE_SLOTS - 1)] = (cycle_slot){h, gen};
+}
+
+/* cycle_check(gol_cycle*, const gol_board*, long);
+ * Called after every single generation step. Looks the board up in the history and
+ * checks a candidate cycle once its period has gone by.
+ * @param cy: the detector
+ * @param board: board after the step
+ * @param gen: generation board is at
+ * @return: period of the cycle once it is confirmed (board repeats every period
+ * generations from here on), 0 otherwise
+ */
+long cycle_check(gol_cycle* cy, const gol_board* board, long gen) {
+    if (cy->period > 0) {
+        return 0;
+    }
+    uint64_t h = board_hash(cy, board);
+    cycle_slot* slot = &cy->table[h & (CYCLE_SLOTS - 1)];
+
+    if (cy->candGen >= 0) {
+        long p = cy->candGen - cy->candStart;
+        if (gen < cy->candGen + p) {
+            return 0;
+        }
+        if (same_board(board, cy->copy)) {
+            cy->start = cy->candStart;
+            cy->period = p;
+            return p;
+        }
+        // two boards with the same hash, keep looking
+        cy->collisions++;
+        cy->candGen = -1;
+    }
+    else if (slot->gen >= 0 && slot->hash == h) {
+        // the board from slot->gen may be back, keep this one and see if it comes back too
+        memcpy(cy->copy->cells, board->cells, (size_t)board->row * board->stride * sizeof(uint64_t));
+        cy->candGen = gen;
+        cy->candStart = slot->gen;
+        return 0;
+    }
+    *slot = (cycle_slot){h, gen};
+    return 0;
+}
+
+/* free_cycle(gol_cycle**);
+ * Frees the detector and sets the caller's pointer to NULL. The boards given to
+ * create_cycle must not be stepped afterwards.
+ * @param pc: pointer to the gol_cycle*
+ */
+void free_cycle(gol_cycle** pc) {
+    gol_cycle* cy = *pc;
+    if (cy->copy != NULL) {
+        free_array(&cy->copy);
+    }
+    free(cy->table);
+    free(cy->hashes);
+    free(cy);
+    *pc = NULL;
+}
@@ -0,0 +1,35 @@
+#ifndef GOL_CYCLE_H
+#define GOL_CYCLE_H
+
+#include "gol_board.h"
+#include "gol_arena.h"
+
+// slots in the history table. A slot keeps only the newest generation that hashed to
+// it, so a cycle (most likely a longer one) can be found late or not at all, never wrongly
+#define CYCLE_SLOTS 4096
+
+// generation a board hash was last seen at
+typedef struct cycle_slot {
+    uint64_t hash;
+    long gen;           // -1 = empty
+} cycle_slot;
+
+// finds the generation a board starts repeating at, and its period
+typedef struct gol_cycle {
+    cycle_slot* table;  // direct mapped on the low bits of the hash
+    uint64_t* hashes;   // row hashes, shared by both boards
+    int rows;           // rows hashes has room for
+    gol_board* copy;    // board at candGen, kept to check a match isn't a hash collision
+    long candGen;       // generation of the copy, -1 = no candidate
+    long candStart;     // generation the copy's hash was first seen at
+    long start;         // first generation of the cycle, -1 until confirmed
+    long period;        // generations per cycle, 0 until confirmed
+    long collisions;    // matches that turned out to be different boards
+} gol_cycle;
+
+gol_cycle* create_cycle(gol_board*, gol_board*, long, gol_arena*);
+void cycle_reset(gol_cycle*, gol_board*, gol_board*, long);
+long cycle_check(gol_cycle*, const gol_board*, long);
+void free_cycle(gol_cycle**);
+
+#endif
@@ -0,0 +1,213 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_display.c
+ * This file shows the board on its own thread so the simulation never waits for the
+ * terminal. The stepping loop checks every generation whether a frame is due, and once
+ * per frame interval copies a snapshot of the board into a small ring of frames, so
+ * between frames showing costs a clock read. The display thread draws each snapshot as it arrives with
+ * the renderer (see gol_render.c). If drawing falls behind, only the newest waiting
+ * snapshot is drawn and the older ones are dropped, and a frame that finds every slot
+ * busy is dropped without copying the board. Dropped frames and the delay from
+ * snapshot to screen are counted.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_display.h"
+#include "gol_io.h"
+#include "gol_sim.h"
+
+/* seconds_since(const struct timespec*);
+ * @return: seconds from t to now on the monotonic clock
+ */
+static double seconds_since(const struct timespec* t) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - t->tv_sec) + (now.tv_nsec - t->tv_nsec) / 1e9;
+}
+
+/* any_ready(const gol_display*);
+ * @return: 1 if a frame is waiting to be drawn. Called with the lock held.
+ */
+static int any_ready(const gol_display* d) {
+    for (int s = 0; s < DISPLAY_SLOTS; s++) {
+        if (d->slots[s].state == SLOT_READY) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* take_newest(gol_display*);
+ * Picks the newest ready frame for drawing and frees the ready frames older than it.
+ * Called with the lock held.
+ * @return: slot of the frame to draw, -1 if none is ready
+ */
+static int take_newest(gol_display* d) {
+    int best = -1;
+    for (int s = 0; s < DISPLAY_SLOTS; s++) {
+        if (d->slots[s].state == SLOT_READY && (best < 0 || d->slots[s].seq > d->slots[best].seq)) {
+            best = s;
+        }
+    }
+    for (int s = 0; s < DISPLAY_SLOTS; s++) {
+        if (s != best && d->slots[s].state == SLOT_READY) {
+            d->slots[s].state = SLOT_FREE;
+            d->dropped++;
+        }
+    }
+    if (best >= 0) {
+        d->slots[best].state = SLOT_DRAWING;
+    }
+    return best;
+}
+
+/* display_loop(void*);
+ * Body of the display thread. Waits for a frame and draws the newest one. Once asked
+ * to quit it draws whatever frame is left and stops.
+ * @param arg: the gol_display
+ */
+static void* display_loop(void* arg) {
+    gol_display* d = arg;
+    char status[64];
+
+    while (1) {
+        pthread_mutex_lock(&d->lock);
+        while (!d->quit && !any_ready(d)) {
+            pthread_cond_wait(&d->ready, &d->lock);
+        }
+        int s = take_newest(d);
+        pthread_mutex_unlock(&d->lock);
+        if (s < 0) {
+            break;
+        }
+
+        gol_frame* f = &d->slots[s];
+        int len = snprintf(status, sizeof(status), "generation %ld", f->gen);
+        // the sparse engine also shows how much of the board it stepped
+        if (f->active >= 0) {
+            snprintf(status + len, sizeof(status) - len, ", %d active tiles", f->active);
+        }
+        render_frame(d->render, f->board, status);
+        double latency = seconds_since(&f->taken);
+
+        pthread_mutex_lock(&d->lock);
+        f->state = SLOT_FREE;
+        d->shown++;
+        d->totalLatency += latency;
+        if (latency > d->maxLatency) {
+            d->maxLatency = latency;
+        }
+        pthread_mutex_unlock(&d->lock);
+    }
+    return NULL;
+}
+
+/* create_display(const gol_board*, int);
+ * Create display allocates a snapshot board for every slot and the renderer, and
+ * starts the display thread.
+ * @param board: the board that will be shown (only its size is used)
+ * @param speed: frames per second
+ * @return: the running display
+ */
+gol_display* create_display(const gol_board* board, int speed) {
+    gol_display* d = calloc(1, sizeof(gol_display));
+    d->render = create_render(board);
+    for (int s = 0; s < DISPLAY_SLOTS; s++) {
+        d->slots[s].board = create_empty_board(board->row, board->col);
+        d->slots[s].state = SLOT_FREE;
+    }
+    d->interval = 1000000000L / speed;
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->ready, NULL);
+    if (pthread_create(&d->thread, NULL, display_loop, d) != 0) {
+        printf("error: unable to start the display thread\n");
+        exit(-1);
+    }
+    return d;
+}
+
+/* display_due(gol_display*);
+ * Asked every generation by the stepping loop. Costs one clock read.
+ * @param d: the display
+ * @return: 1 if a frame should be taken now (see display_push), 0 if not yet
+ */
+int display_due(gol_display* d) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec < d->due.tv_sec || (now.tv_sec == d->due.tv_sec && now.tv_nsec < d->due.tv_nsec)) {
+        return 0;
+    }
+    // next frame one interval on, counted from now if the loop fell behind
+    d->due.tv_nsec += d->interval;
+    d->due.tv_sec += d->due.tv_nsec / 1000000000;
+    d->due.tv_nsec %= 1000000000;
+    if (now.tv_sec > d->due.tv_sec || (now.tv_sec == d->due.tv_sec && now.tv_nsec > d->due.tv_nsec)) {
+        d->due.tv_sec = now.tv_sec + (now.tv_nsec + d->interval) / 1000000000;
+        d->due.tv_nsec = (now.tv_nsec + d->interval) % 1000000000;
+    }
+    return 1;
+}
+
+/* display_push(gol_display*, const gol_board*, long, int);
+ * Hands a frame to the display thread: the board is copied into a free slot if there
+ * is one, otherwise the frame is dropped. Never waits for the display thread.
+ * @param d: the display
+ * @param board: board to show
+ * @param gen: generation the board is at
+ * @param active: active tiles for the sparse engine, -1 otherwise
+ */
+void display_push(gol_display* d, const gol_board* board, long gen, int active) {
+    pthread_mutex_lock(&d->lock);
+    int s = 0;
+    while (s < DISPLAY_SLOTS && d->slots[s].state != SLOT_FREE) {
+        s++;
+    }
+    if (s == DISPLAY_SLOTS) {
+        d->dropped++;
+        pthread_mutex_unlock(&d->lock);
+        return;
+    }
+    d->slots[s].state = SLOT_FILLING;
+    pthread_mutex_unlock(&d->lock);
+
+    gol_frame* f = &d->slots[s];
+    memcpy(f->board->cells, board->cells, (size_t)board->row * board->stride * sizeof(uint64_t));
+    f->gen = gen;
+    f->active = active;
+    clock_gettime(CLOCK_MONOTONIC, &f->taken);
+
+    pthread_mutex_lock(&d->lock);
+    f->seq = ++d->seq;
+    f->state = SLOT_READY;
+    pthread_cond_signal(&d->ready);
+    pthread_mutex_unlock(&d->lock);
+}
+
+/* display_finish(gol_display*);
+ * Lets the display thread draw the last frame pushed, then stops it. shown, dropped
+ * and the latencies are final afterwards.
+ * @param d: the display
+ */
+void display_finish(gol_display* d) {
+    pthread_mutex_lock(&d->lock);
+    d->quit = 1;
+    pthread_cond_signal(&d->ready);
+    pthread_mutex_unlock(&d->lock);
+    pthread_join(d->thread, NULL);
+}
+
+/* free_display(gol_display**);
+ * Frees the snapshots and the renderer (display_finish must have been called) and
+ * sets the caller's pointer to NULL.
+ * @param pd: pointer to the gol_display*
+ */
+void free_display(gol_display** pd) {
+    gol_display* d = *pd;
+    for (int s = 0; s < DISPLAY_SLOTS; s++) {
+        free_array(&d->slots[s].board);
+    }
+    free_render(&d->render);
+    pthread_mutex_destroy(&d->lock);
+    pthread_cond_destroy(&d->ready);
+    free(d);
+    *pd = NULL;
+}
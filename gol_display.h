@@ -0,0 +1,51 @@
+#ifndef GOL_DISPLAY_H
+#define GOL_DISPLAY_H
+
+#include <pthread.h>
+#include <time.h>
+#include "gol_board.h"
+#include "gol_render.h"
+
+// frames that can be held at once: one being drawn, the newest, and one being filled
+#define DISPLAY_SLOTS 3
+
+// states of a slot in the ring
+#define SLOT_FREE 0
+#define SLOT_FILLING 1
+#define SLOT_READY 2
+#define SLOT_DRAWING 3
+
+// one frame snapshot
+typedef struct gol_frame {
+    gol_board* board;       // copy of the board
+    long gen;               // generation it shows
+    int active;             // active tiles for the sparse engine, -1 otherwise
+    long seq;               // order the frames were pushed in
+    int state;              // SLOT_*
+    struct timespec taken;  // when the snapshot was taken
+} gol_frame;
+
+// display thread drawing snapshots of the board taken at a steady frame rate
+typedef struct gol_display {
+    gol_render* render;
+    gol_frame slots[DISPLAY_SLOTS];
+    long seq;               // frames pushed so far
+    long interval;          // nanoseconds between frames
+    struct timespec due;    // when the next frame is taken, only used by the stepping thread
+    int quit;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    long shown;             // frames drawn
+    long dropped;           // frames skipped, either no free slot or replaced by a newer one
+    double totalLatency;    // seconds from snapshot to drawn, summed over shown frames
+    double maxLatency;
+} gol_display;
+
+gol_display* create_display(const gol_board*, int);
+int display_due(gol_display*);
+void display_push(gol_display*, const gol_board*, long, int);
+void display_finish(gol_display*);
+void free_display(gol_display**);
+
+#endif
@@ -0,0 +1,254 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_dist.c
+ * This file splits the board across worker processes (-p). The board is cut into
+ * horizontal bands, one per worker, and each worker keeps only its own band, with a
+ * ghost row above and below it for the neighbouring bands' edge rows. Every generation
+ * a worker publishes its first and last row into a mapping shared by all the workers,
+ * steps the rows of its band that don't need a neighbour while the others do the same,
+ * and then waits at a process shared barrier. Once everyone has published, it copies
+ * the rows next to its band into its ghost rows and steps its two edge rows. The
+ * published rows are kept twice, by generation parity, so a worker that runs ahead
+ * never overwrites rows a slower neighbour still has to read. For nowrap the ghost rows
+ * of the first and last band are never filled and stay dead; for wrap they come from
+ * the band on the other side of the board.
+ * When the run is over each worker writes its band to <config_file>.part<w>, and the
+ * parent stitches the parts into the same output print_board gives.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "gol_dist.h"
+#include "gol_arena.h"
+#include "gol_io.h"
+#include "gol_sim.h"
+#include "gol_rule.h"
+
+/* dist_slot(const gol_dist*, long, int, int);
+ * @return: row published in generation gen by worker w, edge is DIST_TOP or DIST_BOTTOM
+ */
+static uint64_t* dist_slot(const gol_dist* d, long gen, int w, int edge) {
+    return d->slots + ((((size_t)(gen & 1) * d->procs + w) * 2 + edge) * d->stride);
+}
+
+/* step_band(row_fn, const gol_board*, gol_board*, int, int, int);
+ * Runs the row kernel for rows r0 up to (not including) r1 of a band, whose rows
+ * above and below are always there (the band's own rows or its ghost rows).
+ */
+static void step_band(row_fn kernel, const gol_board* old, gol_board* new, int r0, int r1, int wrap) {
+    for (int r = r0; r < r1; r++) {
+        kernel(board_row(old, r - 1), board_row(old, r), board_row(old, r + 1), board_row(new, r), old->col, wrap, &golRule);
+    }
+}
+
+/* part_name(const gol_dist*, int, char*, size_t);
+ * Stores the name of worker w's part file in name.
+ */
+static void part_name(const gol_dist* d, int w, char* name, size_t size) {
+    snprintf(name, size, "%s.part%d", d->parts, w);
+}
+
+/* dist_worker(gol_dist*, gol_board*, int);
+ * Body of worker process w. Copies its band out of the board it inherited, lets go
+ * of the rest, steps the band every generation and writes it to its part file.
+ * Never returns.
+ * @param d: the run, shared with the other workers
+ * @param board: the whole starting board
+ * @param w: which band this worker owns
+ */
+static void dist_worker(gol_dist* d, gol_board* board, int w) {
+    int r0 = (long)w * d->row / d->procs;
+    int r1 = (long)(w + 1) * d->row / d->procs;
+    int n = r1 - r0;
+    size_t bytes = (size_t)d->stride * sizeof(uint64_t);
+
+    // rows 1 to n are the band, rows 0 and n + 1 are the ghost rows
+    gol_arena* arena = create_arena(2 * arena_board_bytes(n + 2, d->col));
+    gol_board* cur = arena_board(arena, n + 2, d->col);
+    gol_board* next = arena_board(arena, n + 2, d->col);
+    memcpy(board_row(cur, 1), board_row(board, r0), n * bytes);
+    // the whole board was only needed to get the band out of it
+    free_array(&board);
+
+    // bands whose ghost rows get filled, and where from
+    int up = (w + d->procs - 1) % d->procs, dn = (w + 1) % d->procs;
+    int fillUp = d->wrap || w > 0, fillDn = d->wrap || w < d->procs - 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &d->start[w]);
+    for (long g = 0; g < d->iter; g++) {
+        memcpy(dist_slot(d, g, w, DIST_TOP), board_row(cur, 1), bytes);
+        memcpy(dist_slot(d, g, w, DIST_BOTTOM), board_row(cur, n), bytes);
+        // the rows that don't touch a ghost row are stepped while the others publish
+        step_band(d->kernel, cur, next, 2, n, d->wrap);
+        pthread_barrier_wait(d->edges);
+
+        if (fillUp) {
+            memcpy(board_row(cur, 0), dist_slot(d, g, up, DIST_BOTTOM), bytes);
+        }
+        if (fillDn) {
+            memcpy(board_row(cur, n + 1), dist_slot(d, g, dn, DIST_TOP), bytes);
+        }
+        step_band(d->kernel, cur, next, 1, 2, d->wrap);
+        if (n > 1) {
+            step_band(d->kernel, cur, next, n, n + 1, d->wrap);
+        }
+        swap_board(&cur, &next);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &d->end[w]);
+
+    char name[4096];
+    part_name(d, w, name, sizeof(name));
+    FILE* part = fopen(name, "w");
+    if (part == NULL) {
+        printf("error: unable to write '%s'\n", name);
+        fflush(stdout);
+        _exit(1);
+    }
+    write_rows(part, cur, 1, n + 1);
+    int failed = ferror(part);
+    if (fclose(part) != 0 || failed) {
+        printf("error: unable to write '%s'\n", name);
+        fflush(stdout);
+        _exit(1);
+    }
+    _exit(0);
+}
+
+/* stitch_parts(const gol_dist*);
+ * Copies every part file to stdout in band order and removes it.
+ * @return: 0 on success, -1 if a part could not be read
+ */
+static int stitch_parts(const gol_dist* d) {
+    char name[4096], buf[65536];
+    int status = 0;
+    for (int w = 0; w < d->procs; w++) {
+        part_name(d, w, name, sizeof(name));
+        FILE* part = fopen(name, "r");
+        if (part == NULL) {
+            printf("error: unable to read '%s'\n", name);
+            status = -1;
+            continue;
+        }
+        size_t got;
+        while ((got = fread(buf, 1, sizeof(buf), part)) > 0) {
+            fwrite(buf, 1, got, stdout);
+        }
+        fclose(part);
+        unlink(name);
+    }
+    return status;
+}
+
+/* run_dist(gol_board*, long, const gol_opts*);
+ * Run dist is simulate_board for -p: forks one worker per band, waits for all of them
+ * and prints the stitched board and the timing lines. If a worker fails the others are
+ * stopped, since they would wait at the barrier forever. The board is freed.
+ * @param board: the starting board
+ * @param iter: generations to run
+ * @param opts: user choices from the command line (wrap, engine, procs)
+ */
+void run_dist(gol_board* board, long iter, const gol_opts* opts) {
+    gol_dist d;
+    d.procs = opts->procs;
+    d.row = board->row;
+    d.col = board->col;
+    d.stride = board->stride;
+    d.wrap = opts->wrap;
+    d.iter = iter;
+    int engine = resolve_engine(opts->engine);
+    d.kernel = pick_row_kernel(engine);
+    d.parts = opts->filename;
+    if (d.procs > d.row) {
+        printf("error: %d processes can not split a board of %d rows\n\n", d.procs, d.row);
+        exit(-1);
+    }
+
+    // barrier, clocks and published rows, each part starting on a cache line
+    size_t barrierBytes = (sizeof(pthread_barrier_t) + GOL_ALIGN - 1) / GOL_ALIGN * GOL_ALIGN;
+    size_t clockBytes = (d.procs * sizeof(struct timespec) + GOL_ALIGN - 1) / GOL_ALIGN * GOL_ALIGN;
+    size_t slotBytes = (size_t)2 * d.procs * 2 * d.stride * sizeof(uint64_t);
+    d.mapBytes = barrierBytes + 2 * clockBytes + slotBytes;
+    d.map = mmap(NULL, d.mapBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (d.map == MAP_FAILED) {
+        printf("error: unable to map %zu bytes shared by the workers\n", d.mapBytes);
+        exit(-1);
+    }
+    d.edges = d.map;
+    d.start = (struct timespec*)((char*)d.map + barrierBytes);
+    d.end = (struct timespec*)((char*)d.map + barrierBytes + clockBytes);
+    d.slots = (uint64_t*)((char*)d.map + barrierBytes + 2 * clockBytes);
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(d.edges, &attr, d.procs);
+    pthread_barrierattr_destroy(&attr);
+
+    // nothing buffered may be written twice by the children
+    fflush(stdout);
+    d.pids = malloc(d.procs * sizeof(pid_t));
+    for (int w = 0; w < d.procs; w++) {
+        d.pids[w] = fork();
+        if (d.pids[w] == 0) {
+            dist_worker(&d, board, w);
+        }
+        if (d.pids[w] < 0) {
+            printf("error: unable to start worker process %d\n", w);
+            for (int k = 0; k < w; k++) {
+                kill(d.pids[k], SIGKILL);
+                waitpid(d.pids[k], NULL, 0);
+            }
+            exit(-1);
+        }
+    }
+    // the workers have their own copies of their bands
+    free_array(&board);
+
+    int failed = 0;
+    for (int k = 0; k < d.procs; k++) {
+        int status;
+        pid_t pid = wait(&status);
+        if (!failed && (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+            failed = 1;
+            for (int w = 0; w < d.procs; w++) {
+                if (d.pids[w] != pid) {
+                    kill(d.pids[w], SIGKILL);
+                }
+            }
+        }
+    }
+    if (failed) {
+        // parts of the workers that did finish are no use without the rest
+        char name[4096];
+        for (int w = 0; w < d.procs; w++) {
+            part_name(&d, w, name, sizeof(name));
+            unlink(name);
+        }
+    }
+    if (failed || stitch_parts(&d) != 0) {
+        printf("error: a worker process failed, no board was produced\n");
+        exit(-1);
+    }
+    printf("\n");
+
+    // from the first worker starting to the last one finishing
+    struct timespec first = d.start[0], last = d.end[0];
+    for (int w = 1; w < d.procs; w++) {
+        if (d.start[w].tv_sec < first.tv_sec || (d.start[w].tv_sec == first.tv_sec && d.start[w].tv_nsec < first.tv_nsec)) {
+            first = d.start[w];
+        }
+        if (d.end[w].tv_sec > last.tv_sec || (d.end[w].tv_sec == last.tv_sec && d.end[w].tv_nsec > last.tv_nsec)) {
+            last = d.end[w];
+        }
+    }
+    double elapsed = (last.tv_sec - first.tv_sec) + (last.tv_nsec - first.tv_nsec) / 1e9;
+    printf("Total time for %ld iterations of %dx%d is %.6f using %s%s%s\n", iter, d.row, d.col,
+           elapsed, engine_name(engine), golRule.conway ? "" : ", rule ", golRule.conway ? "" : golRule.name);
+    printf("Throughput: %.3e cell updates/s on %d process(es)\n", (double)d.row * d.col * iter / elapsed, d.procs);
+
+    pthread_barrier_destroy(d.edges);
+    munmap(d.map, d.mapBytes);
+    free(d.pids);
+}
@@ -0,0 +1,36 @@
+#ifndef GOL_DIST_H
+#define GOL_DIST_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <time.h>
+#include "gol_board.h"
+#include "gol_cmd.h"
+#include "gol_swar.h"
+
+// the two edge rows a worker publishes every generation
+#define DIST_TOP 0
+#define DIST_BOTTOM 1
+
+// a board split into horizontal bands, each stepped by its own worker process
+typedef struct gol_dist {
+    int procs;                  // number of worker processes (and bands)
+    int row;                    // rows of the whole board
+    int col;                    // cols of the whole board
+    int stride;                 // words per row
+    int wrap;                   // 1 wrap, 0 nowrap
+    long iter;                  // generations every worker runs
+    row_fn kernel;              // row kernel every band runs
+    char* parts;                // part files are <parts>.part<w>
+    void* map;                  // shared mapping of everything below, made before the fork
+    size_t mapBytes;
+    pthread_barrier_t* edges;   // released once every worker has published its edge rows
+    struct timespec* start;     // when each worker started stepping
+    struct timespec* end;       // when each worker stopped stepping
+    uint64_t* slots;            // published rows, [generation & 1][worker][DIST_TOP/DIST_BOTTOM]
+    pid_t* pids;                // the workers, only in the parent
+} gol_dist;
+
+void run_dist(gol_board*, long, const gol_opts*);
+
+#endif
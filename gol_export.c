@@ -0,0 +1,446 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_export.c
+ * This file records a run as a frame file that can be replayed afterwards, instead of
+ * watching it live. Every Nth generation the stepping loop copies the packed board into
+ * one of a few slots and moves on; an encoder thread compares it with the frame before
+ * and writes only what changed. A frame lists the rows that differ from the last frame,
+ * and each of those rows as runs of unchanged words (skipped) and changed words (stored
+ * XORed with the last frame), with counts as variable length integers. A board that
+ * barely moves costs a few bytes per frame, and the first frame is stored against an
+ * all dead board. The loop only waits when every slot is still waiting for the encoder,
+ * so no frame is ever lost.
+ * A frame file is an export_header, then per frame an export_frame and its encoded rows.
+ * Like snapshots, it uses the byte order of the machine that wrote it.
+ * Replaying (--replay) reads the frames back in order and shows or prints each one.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gol_export.h"
+#include "gol_io.h"
+#include "gol_render.h"
+#include "gol_rule.h"
+#include "gol_sim.h"
+
+_Static_assert(sizeof(export_header) == GOL_ALIGN, "frame file header must be GOL_ALIGN bytes");
+
+// bytes the write buffer of the frame file holds
+#define EXPORT_BUFFER (1 << 20)
+
+/* put_varint(unsigned char*, uint64_t);
+ * Stores v 7 bits per byte, low bits first, the top bit set on every byte but the last.
+ * @return: pointer past the last byte stored
+ */
+static unsigned char* put_varint(unsigned char* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+/* get_varint(const unsigned char**, const unsigned char*, uint64_t*);
+ * Reads a value stored by put_varint and moves *pp past it.
+ * @return: 0 on success, -1 if it runs past end or is too long
+ */
+static int get_varint(const unsigned char** pp, const unsigned char* end, uint64_t* v) {
+    const unsigned char* p = *pp;
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) {
+            return -1;
+        }
+        value |= (uint64_t)(*p & 0x7F) << shift;
+        if ((*p++ & 0x80) == 0) {
+            *v = value;
+            *pp = p;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* encode_frame(gol_export*, const uint64_t*, uint32_t*);
+ * Encodes the rows of cells that differ from the last frame into ex->enc. Each one is
+ * the number of unchanged rows before it, then pairs of (unchanged words, changed
+ * words) followed by the changed words XORed with the last frame, until the row ends.
+ * @param ex: the exporter
+ * @param cells: the frame, laid out like a board's cells
+ * @param prows: set to the number of rows encoded
+ * @return: bytes stored in ex->enc
+ */
+static size_t encode_frame(gol_export* ex, const uint64_t* cells, uint32_t* prows) {
+    unsigned char* p = ex->enc;
+    uint32_t rows = 0;
+    int last = -1, words = ex->words;
+
+    for (int r = 0; r < ex->row; r++) {
+        const uint64_t* a = cells + (size_t)r * ex->stride;
+        const uint64_t* b = ex->prev + (size_t)r * ex->stride;
+        if (memcmp(a, b, words * sizeof(uint64_t)) == 0) {
+            continue;
+        }
+        p = put_varint(p, r - last - 1);
+        last = r;
+        rows++;
+        int w = 0;
+        while (w < words) {
+            int z = w;
+            while (z < words && a[z] == b[z]) {
+                z++;
+            }
+            int l = z;
+            while (l < words && a[l] != b[l]) {
+                l++;
+            }
+            p = put_varint(p, z - w);
+            p = put_varint(p, l - z);
+            for (int k = z; k < l; k++) {
+                uint64_t x = a[k] ^ b[k];
+                memcpy(p, &x, sizeof(x));
+                p += sizeof(x);
+            }
+            w = l;
+        }
+    }
+    *prows = rows;
+    return p - ex->enc;
+}
+
+/* write_frame(gol_export*, const uint64_t*, long);
+ * Encodes and writes one frame. Runs on the encoder thread only.
+ * @return: 0 on success, -1 if it could not be written
+ */
+static int write_frame(gol_export* ex, const uint64_t* cells, long gen) {
+    export_frame head;
+    memcpy(head.magic, EXPORT_FRAME_MAGIC, sizeof(head.magic));
+    head.generation = gen;
+    size_t n = encode_frame(ex, cells, &head.rows);
+    head.bytes = n;
+    if (fwrite(&head, sizeof(head), 1, ex->out) != 1 || fwrite(ex->enc, 1, n, ex->out) != n) {
+        return -1;
+    }
+    ex->frames++;
+    ex->bytes += sizeof(head) + n;
+    return 0;
+}
+
+/* oldest_slot(const gol_export*);
+ * @return: the slot filled first of those waiting for the encoder, -1 if none is.
+ * Called with the lock held.
+ */
+static int oldest_slot(const gol_export* ex) {
+    int best = -1;
+    for (int s = 0; s < EXPORT_SLOTS; s++) {
+        if (ex->seq[s] > 0 && (best < 0 || ex->seq[s] < ex->seq[best])) {
+            best = s;
+        }
+    }
+    return best;
+}
+
+/* export_encoder(void*);
+ * Body of the encoder thread. Encodes the waiting boards in the order they came in,
+ * until asked to quit with none left.
+ * @param arg: the gol_export
+ */
+static void* export_encoder(void* arg) {
+    gol_export* ex = arg;
+
+    pthread_mutex_lock(&ex->lock);
+    while (1) {
+        int s;
+        while ((s = oldest_slot(ex)) < 0 && !ex->quit) {
+            pthread_cond_wait(&ex->wake, &ex->lock);
+        }
+        if (s < 0) {
+            break;
+        }
+        pthread_mutex_unlock(&ex->lock);
+
+        if (!ex->failed && write_frame(ex, ex->slot[s], ex->gen[s]) != 0) {
+            printf("error: unable to write frames to '%s', the run continues\n", ex->path);
+            ex->failed = 1;
+        }
+
+        pthread_mutex_lock(&ex->lock);
+        // the frame just written is what the next one is compared with
+        uint64_t* done = ex->slot[s];
+        ex->slot[s] = ex->prev;
+        ex->prev = done;
+        ex->seq[s] = 0;
+        pthread_cond_signal(&ex->freed);
+    }
+    pthread_mutex_unlock(&ex->lock);
+    return NULL;
+}
+
+/* create_export(const gol_board*, int, int, char*);
+ * Create export allocates the slots and the encoding buffer for a board of this size,
+ * writes the file header and starts the encoder thread. Frames go to <filename>.frames.
+ * @param board: board that will be exported (only its size is used here)
+ * @param wrap: 1 wrap, 0 nowrap
+ * @param every: generations between frames
+ * @param filename: the input file the frame file is named after
+ * @return: the running exporter
+ */
+gol_export* create_export(const gol_board* board, int wrap, int every, char* filename) {
+    gol_export* ex = calloc(1, sizeof(gol_export));
+    ex->path = malloc(strlen(filename) + 8);
+    sprintf(ex->path, "%s.frames", filename);
+    ex->row = board->row;
+    ex->words = board->words;
+    ex->stride = board->stride;
+
+    size_t bytes = (size_t)board->row * board->stride * sizeof(uint64_t);
+    // every row changed in every other word is the most a frame can take
+    ex->encCap = (size_t)board->row * ((size_t)board->words * 14 + 16);
+    ex->enc = malloc(ex->encCap);
+    ex->prev = calloc(1, bytes);
+    ex->buffer = malloc(EXPORT_BUFFER);
+    int ok = (ex->enc != NULL && ex->prev != NULL && ex->buffer != NULL);
+    for (int s = 0; s < EXPORT_SLOTS; s++) {
+        ex->slot[s] = malloc(bytes);
+        ok = ok && ex->slot[s] != NULL;
+    }
+    if (!ok) {
+        printf("error: unable to allocate export buffers for a %dx%d board\n", board->row, board->col);
+        exit(-1);
+    }
+
+    // the file and its buffer are set up here so the encoder never allocates
+    ex->out = fopen(ex->path, "wb");
+    if (ex->out == NULL) {
+        printf("error: unable to create '%s'\n", ex->path);
+        exit(-1);
+    }
+    setvbuf(ex->out, ex->buffer, _IOFBF, EXPORT_BUFFER);
+    export_header head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, EXPORT_MAGIC, sizeof(head.magic));
+    head.version = EXPORT_VERSION;
+    head.wrap = wrap;
+    head.row = board->row;
+    head.col = board->col;
+    head.words = board->words;
+    head.every = every;
+    head.born = golRule.born;
+    head.survive = golRule.survive;
+    if (fwrite(&head, sizeof(head), 1, ex->out) != 1) {
+        printf("error: unable to write '%s'\n", ex->path);
+        exit(-1);
+    }
+    ex->bytes = sizeof(head);
+
+    pthread_mutex_init(&ex->lock, NULL);
+    pthread_cond_init(&ex->wake, NULL);
+    pthread_cond_init(&ex->freed, NULL);
+    if (pthread_create(&ex->thread, NULL, export_encoder, ex) != 0) {
+        printf("error: unable to start the export encoder\n");
+        exit(-1);
+    }
+    return ex;
+}
+
+/* export_push(gol_export*, const gol_board*, long);
+ * Copies the board into a free slot and hands it to the encoder. Waits (counted in
+ * waits) only if every slot is still waiting to be encoded.
+ * @param ex: the exporter
+ * @param board: board to export
+ * @param gen: generation the board is at
+ */
+void export_push(gol_export* ex, const gol_board* board, long gen) {
+    pthread_mutex_lock(&ex->lock);
+    int s = 0;
+    while (s < EXPORT_SLOTS && ex->seq[s] != 0) {
+        s++;
+    }
+    if (s == EXPORT_SLOTS) {
+        ex->waits++;
+    }
+    while (s == EXPORT_SLOTS) {
+        pthread_cond_wait(&ex->freed, &ex->lock);
+        s = 0;
+        while (s < EXPORT_SLOTS && ex->seq[s] != 0) {
+            s++;
+        }
+    }
+    // being filled, not free and not yet for the encoder
+    ex->seq[s] = -1;
+    pthread_mutex_unlock(&ex->lock);
+
+    memcpy(ex->slot[s], board->cells, (size_t)ex->row * ex->stride * sizeof(uint64_t));
+    ex->gen[s] = gen;
+
+    pthread_mutex_lock(&ex->lock);
+    ex->seq[s] = ++ex->pushed;
+    pthread_cond_signal(&ex->wake);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/* export_finish(gol_export*);
+ * Waits for every board handed over to be encoded, stops the encoder and closes the
+ * file, after which frames, bytes and waits are final.
+ * @param ex: the exporter
+ */
+void export_finish(gol_export* ex) {
+    if (ex->finished) {
+        return;
+    }
+    pthread_mutex_lock(&ex->lock);
+    ex->quit = 1;
+    pthread_cond_signal(&ex->wake);
+    pthread_mutex_unlock(&ex->lock);
+    pthread_join(ex->thread, NULL);
+    if (fclose(ex->out) != 0 && !ex->failed) {
+        printf("error: unable to write frames to '%s'\n", ex->path);
+        ex->failed = 1;
+    }
+    ex->finished = 1;
+}
+
+/* free_export(gol_export**);
+ * Stops the encoder (see export_finish) if it is still running and frees the buffers.
+ * The caller's pointer is set to NULL.
+ * @param pex: pointer to the gol_export*
+ */
+void free_export(gol_export** pex) {
+    gol_export* ex = *pex;
+    export_finish(ex);
+
+    pthread_mutex_destroy(&ex->lock);
+    pthread_cond_destroy(&ex->wake);
+    pthread_cond_destroy(&ex->freed);
+    for (int s = 0; s < EXPORT_SLOTS; s++) {
+        free(ex->slot[s]);
+    }
+    free(ex->prev);
+    free(ex->enc);
+    free(ex->buffer);
+    free(ex->path);
+    free(ex);
+    *pex = NULL;
+}
+
+/* apply_frame(gol_board*, const unsigned char*, uint32_t, uint64_t);
+ * Turns the board from the last frame into this one, given the frame's encoded rows.
+ * Everything read is checked against the board and the frame's size.
+ * @return: 0 on success, -1 if the encoded rows are corrupt
+ */
+static int apply_frame(gol_board* board, const unsigned char* p, uint32_t rows, uint64_t bytes) {
+    const unsigned char* end = p + bytes;
+    uint64_t words = board->words;
+    long r = -1;
+
+    for (uint32_t i = 0; i < rows; i++) {
+        uint64_t skip;
+        if (get_varint(&p, end, &skip) != 0 || skip >= (uint64_t)board->row - (r + 1)) {
+            return -1;
+        }
+        r += skip + 1;
+        uint64_t* cells = board_row(board, r);
+        uint64_t w = 0;
+        while (w < words) {
+            uint64_t same, changed;
+            if (get_varint(&p, end, &same) != 0 || get_varint(&p, end, &changed) != 0) {
+                return -1;
+            }
+            if ((same == 0 && changed == 0) || same > words - w || changed > words - w - same ||
+                changed * sizeof(uint64_t) > (uint64_t)(end - p)) {
+                return -1;
+            }
+            w += same;
+            for (uint64_t k = 0; k < changed; k++) {
+                uint64_t x;
+                memcpy(&x, p, sizeof(x));
+                cells[w++] ^= x;
+                p += sizeof(x);
+            }
+        }
+    }
+    return p == end ? 0 : -1;
+}
+
+/* run_replay(const gol_opts*);
+ * Run replay plays a frame file back. With show, every frame is drawn at the speed asked
+ * for; with hide, every frame is printed as its generation followed by the board.
+ * @param opts: the frame file (replay), show and speed
+ * @return: 0 on success, -1 if the file is not a frame file or is damaged
+ */
+int run_replay(const gol_opts* opts) {
+    int fd = open(opts->replay, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(export_header)) {
+        printf("error: '%s' is not a frame file\n\n", opts->replay);
+        return -1;
+    }
+    const unsigned char* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("error: unable to map '%s'\n\n", opts->replay);
+        return -1;
+    }
+    const unsigned char* end = map + info.st_size;
+    export_header head;
+    memcpy(&head, map, sizeof(head));
+    if (memcmp(head.magic, EXPORT_MAGIC, sizeof(head.magic)) != 0 || head.version != EXPORT_VERSION ||
+        head.row <= 0 || head.col <= 0 || head.row > GOL_MAX_SIDE || head.col > GOL_MAX_SIDE) {
+        printf("error: '%s' is not a frame file of this version\n\n", opts->replay);
+        munmap((void*)map, info.st_size);
+        return -1;
+    }
+
+    gol_board* board = create_empty_board(head.row, head.col);
+    gol_render* render = (opts->show == 1) ? create_render(board) : NULL;
+    render_clear();
+    struct timespec pause = {0, 1000000000L / (opts->speed > 0 ? opts->speed : 1)};
+    char status[64];
+    long frames = 0;
+    int damaged = 0;
+
+    const unsigned char* p = map + sizeof(head);
+    while (p < end) {
+        export_frame frame;
+        if ((size_t)(end - p) < sizeof(frame)) {
+            damaged = 1;
+            break;
+        }
+        memcpy(&frame, p, sizeof(frame));
+        p += sizeof(frame);
+        if (memcmp(frame.magic, EXPORT_FRAME_MAGIC, sizeof(frame.magic)) != 0 || frame.bytes > (uint64_t)(end - p) ||
+            apply_frame(board, p, frame.rows, frame.bytes) != 0) {
+            damaged = 1;
+            break;
+        }
+        p += frame.bytes;
+        frames++;
+        if (render != NULL) {
+            snprintf(status, sizeof(status), "generation %lld, frame %ld", (long long)frame.generation, frames);
+            render_frame(render, board, status);
+            nanosleep(&pause, NULL);
+        }
+        else {
+            printf("Generation %lld\n", (long long)frame.generation);
+            print_board(board);
+        }
+    }
+    if (render != NULL) {
+        render_clear();
+        print_board(board);
+        free_render(&render);
+    }
+    if (damaged) {
+        printf("error: '%s' is damaged after frame %ld\n", opts->replay, frames);
+    }
+    printf("Replayed %ld frames of %dx%d from %s (%s, one every %d generations)\n", frames, head.row, head.col,
+           opts->replay, head.wrap ? "wrap" : "nowrap", head.every);
+
+    free_array(&board);
+    munmap((void*)map, info.st_size);
+    return damaged ? -1 : 0;
+}
@@ -0,0 +1,68 @@
+#ifndef GOL_EXPORT_H
+#define GOL_EXPORT_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include "gol_board.h"
+#include "gol_cmd.h"
+
+// first bytes of every frame file, and the layout version that follows them
+#define EXPORT_MAGIC "GOLFRMS"
+#define EXPORT_VERSION 1
+// first bytes of every frame in the file
+#define EXPORT_FRAME_MAGIC "FRME"
+// boards that can wait for the encoder at once
+#define EXPORT_SLOTS 3
+
+// fixed size header at the start of a frame file
+typedef struct export_header {
+    char magic[8];          // EXPORT_MAGIC
+    uint32_t version;       // EXPORT_VERSION
+    int32_t wrap;           // 1 wrap, 0 nowrap
+    int32_t row, col;       // board size
+    int32_t words;          // words in a row of cells
+    int32_t every;          // generations between frames
+    uint16_t born, survive; // rule the board was stepped with, see gol_rule.h
+    uint8_t unused[GOL_ALIGN - 36];
+} export_header;
+
+// header of one frame, its encoded rows follow it (see gol_export.c)
+typedef struct export_frame {
+    char magic[4];          // EXPORT_FRAME_MAGIC
+    uint32_t rows;          // rows that changed since the last frame
+    int64_t generation;     // generation the frame shows
+    uint64_t bytes;         // bytes of encoded rows that follow
+} export_frame;
+
+// background encoder writing every Nth generation to a frame file
+typedef struct gol_export {
+    char* path;             // frame file
+    FILE* out;
+    char* buffer;           // write buffer of out
+    int row, words, stride;
+    uint64_t* slot[EXPORT_SLOTS];   // copies of boards waiting for the encoder
+    long gen[EXPORT_SLOTS];         // generation in each slot
+    long seq[EXPORT_SLOTS];         // order the slots were filled in, 0 = free
+    long pushed;            // boards handed to the encoder so far
+    uint64_t* prev;         // last frame encoded, all 0's before the first
+    unsigned char* enc;     // encoded rows of the frame being written
+    size_t encCap;          // size of enc
+    int quit;
+    int finished;           // encoder has been stopped and joined
+    int failed;             // a write failed, the rest of the run is not exported
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // a slot was filled, or quit
+    pthread_cond_t freed;   // a slot was emptied
+    long frames;            // frames written
+    uint64_t bytes;         // bytes written, header included
+    long waits;             // times the stepping loop waited for a free slot
+} gol_export;
+
+gol_export* create_export(const gol_board*, int, int, char*);
+void export_push(gol_export*, const gol_board*, long);
+void export_finish(gol_export*);
+void free_export(gol_export**);
+int run_replay(const gol_opts*);
+
+#endif
@@ -0,0 +1,392 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_hash.c
+ * This file is the HashLife engine, for runs far too long to step one generation at a
+ * time. The board is a quadtree whose identical squares are stored once (hash consing),
+ * and the RESULT of every square, its centre half 2^(level-2) generations later, is
+ * remembered on the node. Repeated structure in space and in time then costs nothing,
+ * and a root of level L jumps 2^(L-2) generations in one call.
+ *
+ * A wrapped board is a torus, which is the same as the plane tiled with copies of the
+ * board. The root for a jump is built from that tiling, so no cell ever sees an edge,
+ * and the RESULT is read back into the board modulo its size. A board only has
+ * row x col distinct phases, so even a root of level 60 needs about row x col nodes
+ * per level.
+ * The node store never grows past the -m cap. A jump that fills it is given up (a
+ * longjmp out of the recursion, see new_node), the store is emptied and the jump is
+ * started again, and halved each time it fills the store again.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_hash.h"
+#include "gol_sim.h"
+
+/* hash4(const uint32_t*);
+ * @return: hash of the four children of a node
+ */
+static inline uint32_t hash4(const uint32_t* c) {
+    uint64_t h = c[0] * 0x9E3779B97F4A7C15ull;
+    h = (h ^ c[1]) * 0xC2B2AE3D27D4EB4Full;
+    h = (h ^ c[2]) * 0x165667B19E3779F9ull;
+    h = (h ^ c[3]) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32);
+}
+
+/* rehash(gol_hash*, uint32_t);
+ * Rebuilds the bucket table with the given (power of 2) number of buckets, linking in
+ * every node above the leaves that is not on the free list.
+ */
+static void rehash(gol_hash* hl, uint32_t buckets) {
+    free(hl->table);
+    hl->buckets = buckets;
+    hl->table = malloc(buckets * sizeof(uint32_t));
+    if (hl->table == NULL) {
+        printf("error: unable to allocate %u hashlife buckets\n", buckets);
+        exit(-1);
+    }
+    memset(hl->table, 0xFF, buckets * sizeof(uint32_t));
+    for (uint32_t i = 2; i < hl->used; i++) {
+        if (hl->nodes[i].mark != 0xFF) {
+            uint32_t b = hash4(hl->nodes[i].child) & (buckets - 1);
+            hl->nodes[i].next = hl->table[b];
+            hl->table[b] = i;
+        }
+    }
+}
+
+/* new_node(gol_hash*);
+ * Only called during a jump (see hash_advance). When every slot allowed by the memory
+ * cap is in use, the jump is given up by jumping back to hl->full.
+ * @return: index of an unused node slot, from the free list or by growing the array
+ */
+static uint32_t new_node(gol_hash* hl) {
+    if (hl->freed != HL_NONE) {
+        uint32_t n = hl->freed;
+        hl->freed = hl->nodes[n].next;
+        return n;
+    }
+    if (hl->used == hl->slots) {
+        if (hl->slots >= hl->limit) {
+            longjmp(hl->full, 1);
+        }
+        size_t slots = (size_t)hl->slots * 2 < hl->limit ? (size_t)hl->slots * 2 : hl->limit;
+        if (slots >= HL_NONE / 2) {
+            printf("error: hashlife ran out of node indices, lower -m\n");
+            exit(-1);
+        }
+        hl_node* grown = realloc(hl->nodes, slots * sizeof(hl_node));
+        if (grown == NULL) {
+            printf("error: hashlife ran out of memory\n");
+            exit(-1);
+        }
+        hl->nodes = grown;
+        hl->slots = slots;
+    }
+    return hl->used++;
+}
+
+/* join(gol_hash*, uint32_t, uint32_t, uint32_t, uint32_t);
+ * Join returns the one node with these four quadrants, creating it the first time.
+ * Note that this can move hl->nodes, so no hl_node* may be held across a call.
+ * @return: index of the node one level above its children
+ */
+static uint32_t join(gol_hash* hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t c[4] = {nw, ne, sw, se};
+    uint32_t b = hash4(c) & (hl->buckets - 1);
+    for (uint32_t n = hl->table[b]; n != HL_NONE; n = hl->nodes[n].next) {
+        if (memcmp(hl->nodes[n].child, c, sizeof(c)) == 0) {
+            return n;
+        }
+    }
+    uint32_t n = new_node(hl);
+    hl_node* node = &hl->nodes[n];
+    memcpy(node->child, c, sizeof(c));
+    node->result = HL_NONE;
+    node->level = hl->nodes[nw].level + 1;
+    node->mark = 0;
+    node->next = hl->table[b];
+    hl->table[b] = n;
+    if (++hl->live > hl->buckets) {
+        rehash(hl, hl->buckets * 2);
+    }
+    return n;
+}
+
+/* base_result(gol_hash*, uint32_t);
+ * RESULT of a level 2 node: the centre 2x2 of its 4x4 cells after one generation.
+ */
+static uint32_t base_result(gol_hash* hl, uint32_t n) {
+    int cell[4][4], next[4];
+    for (int q = 0; q < 4; q++) {
+        const hl_node* quad = &hl->nodes[hl->nodes[n].child[q]];
+        for (int i = 0; i < 4; i++) {
+            cell[(q / 2) * 2 + i / 2][(q % 2) * 2 + i % 2] = (int)quad->child[i];
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        int r = 1 + i / 2, c = 1 + i % 2, sum = 0;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                sum += (dr || dc) ? cell[r + dr][c + dc] : 0;
+            }
+        }
+        next[i] = judgement_day(sum, cell[r][c]);
+    }
+    return join(hl, next[0], next[1], next[2], next[3]);
+}
+
+/* centre_of(gol_hash*, uint32_t, uint32_t, uint32_t, uint32_t, int, int, int, int);
+ * @return: the node made of quadrant qa of a, qb of b, qc of c and qd of d
+ */
+static uint32_t centre_of(gol_hash* hl, uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+                          int qa, int qb, int qc, int qd) {
+    return join(hl, hl->nodes[a].child[qa], hl->nodes[b].child[qb],
+                hl->nodes[c].child[qc], hl->nodes[d].child[qd]);
+}
+
+/* result(gol_hash*, uint32_t);
+ * RESULT of a node of level 3 or more, by the usual two stage recursion: nine overlapping
+ * squares of the next level down are advanced 2^(level-3) generations, grouped into four,
+ * and advanced 2^(level-3) more. Memoized on the node.
+ * @return: node one level down holding the centre 2^(level-2) generations later
+ */
+static uint32_t result(gol_hash* hl, uint32_t n) {
+    if (hl->nodes[n].result != HL_NONE) {
+        return hl->nodes[n].result;
+    }
+    if (hl->nodes[n].level == 2) {
+        uint32_t r = base_result(hl, n);
+        hl->nodes[n].result = r;
+        return r;
+    }
+    uint32_t nw = hl->nodes[n].child[0], ne = hl->nodes[n].child[1];
+    uint32_t sw = hl->nodes[n].child[2], se = hl->nodes[n].child[3];
+    uint32_t m[9];
+    m[0] = result(hl, nw);
+    m[1] = result(hl, centre_of(hl, nw, ne, nw, ne, 1, 0, 3, 2));
+    m[2] = result(hl, ne);
+    m[3] = result(hl, centre_of(hl, nw, nw, sw, sw, 2, 3, 0, 1));
+    m[4] = result(hl, centre_of(hl, nw, ne, sw, se, 3, 2, 1, 0));
+    m[5] = result(hl, centre_of(hl, ne, ne, se, se, 2, 3, 0, 1));
+    m[6] = result(hl, sw);
+    m[7] = result(hl, centre_of(hl, sw, se, sw, se, 1, 0, 3, 2));
+    m[8] = result(hl, se);
+    uint32_t r = join(hl, result(hl, join(hl, m[0], m[1], m[3], m[4])),
+                      result(hl, join(hl, m[1], m[2], m[4], m[5])),
+                      result(hl, join(hl, m[3], m[4], m[6], m[7])),
+                      result(hl, join(hl, m[4], m[5], m[7], m[8])));
+    hl->nodes[n].result = r;
+    return r;
+}
+
+/* mark(gol_hash*, uint32_t);
+ * Marks a node, everything under it and everything it has memoized as in use.
+ */
+static void mark(gol_hash* hl, uint32_t n) {
+    if (n == HL_NONE || hl->nodes[n].mark == 1) {
+        return;
+    }
+    hl->nodes[n].mark = 1;
+    if (hl->nodes[n].level > 0) {
+        for (int q = 0; q < 4; q++) {
+            mark(hl, hl->nodes[n].child[q]);
+        }
+        mark(hl, hl->nodes[n].result);
+    }
+}
+
+/* collect(gol_hash*, uint32_t);
+ * Garbage collects the node store: everything not reachable from keep (through children
+ * or memoized results) goes on the free list.
+ * @param keep: root to keep, HL_NONE to keep only the two leaves
+ */
+static void collect(gol_hash* hl, uint32_t keep) {
+    for (uint32_t i = 0; i < hl->used; i++) {
+        hl->nodes[i].mark = (hl->nodes[i].mark == 0xFF) ? 0xFF : 0;
+    }
+    mark(hl, 0);
+    mark(hl, 1);
+    mark(hl, keep);
+    hl->live = 0;
+    hl->freed = HL_NONE;
+    for (uint32_t i = hl->used; i-- > 2;) {
+        if (hl->nodes[i].mark != 1) {
+            hl->nodes[i].mark = 0xFF;
+            hl->nodes[i].next = hl->freed;
+            hl->freed = i;
+        }
+        else {
+            hl->live++;
+        }
+    }
+    rehash(hl, hl->buckets);
+    hl->collections++;
+}
+
+/* pow2_mod(int, long);
+ * @return: 2^e mod m, for e far past 64
+ */
+static long pow2_mod(int e, long m) {
+    long v = 1 % m;
+    for (int i = 0; i < e; i++) {
+        v = (v * 2) % m;
+    }
+    return v;
+}
+
+/* build_root(gol_hash*, const gol_board*, int);
+ * Builds the level L node whose top left corner is cell 0, 0 of the board tiled across
+ * the plane. Level l+1 at (y, x) joins the level l nodes at (y, x), (y, x + 2^l),
+ * (y + 2^l, x) and (y + 2^l, x + 2^l), every coordinate taken modulo the board size.
+ * @return: the root
+ */
+static uint32_t build_root(gol_hash* hl, const gol_board* board, int L) {
+    int row = board->row, col = board->col;
+    for (int r = 0; r < row; r++) {
+        for (int c = 0; c < col; c++) {
+            hl->grid[(size_t)r * col + c] = (uint32_t)get_cell(board, r, c);
+        }
+    }
+    for (int l = 0; l < L; l++) {
+        long hr = pow2_mod(l, row), hc = pow2_mod(l, col);
+        for (int r = 0; r < row; r++) {
+            const uint32_t* top = hl->grid + (size_t)r * col;
+            const uint32_t* bot = hl->grid + (size_t)((r + hr) % row) * col;
+            for (int c = 0; c < col; c++) {
+                int c2 = (int)((c + hc) % col);
+                hl->grid2[(size_t)r * col + c] = join(hl, top[c], top[c2], bot[c], bot[c2]);
+            }
+        }
+        uint32_t* t = hl->grid;
+        hl->grid = hl->grid2;
+        hl->grid2 = t;
+    }
+    return hl->grid[0];
+}
+
+/* node_cell(const gol_hash*, uint32_t, uint64_t, uint64_t);
+ * @return: the cell at row y, column x inside node n
+ */
+static int node_cell(const gol_hash* hl, uint32_t n, uint64_t y, uint64_t x) {
+    while (hl->nodes[n].level > 0) {
+        int l = hl->nodes[n].level;
+        uint64_t half = (uint64_t)1 << (l - 1);
+        int q = (y >= half ? 2 : 0) + (x >= half ? 1 : 0);
+        y = (y >= half) ? y - half : y;
+        x = (x >= half) ? x - half : x;
+        n = hl->nodes[n].child[q];
+    }
+    return (int)n;
+}
+
+/* create_hash(const gol_board*, long);
+ * Create hash sets up an empty node store for a board.
+ * @param board: the board that will be advanced
+ * @param capMB: memory cap for the node store in megabytes
+ * @return: the HashLife engine
+ */
+gol_hash* create_hash(const gol_board* board, long capMB) {
+    gol_hash* hl = malloc(sizeof(gol_hash));
+    if (hl == NULL) {
+        printf("error: unable to allocate the hashlife engine\n");
+        exit(-1);
+    }
+    hl->slots = 1024;
+    hl->nodes = malloc(hl->slots * sizeof(hl_node));
+    hl->grid = malloc((size_t)board->row * board->col * sizeof(uint32_t));
+    hl->grid2 = malloc((size_t)board->row * board->col * sizeof(uint32_t));
+    if (hl->nodes == NULL || hl->grid == NULL || hl->grid2 == NULL) {
+        printf("error: unable to allocate the hashlife engine for a %dx%d board\n", board->row, board->col);
+        exit(-1);
+    }
+    // node 0 is a dead cell and node 1 a live one
+    memset(hl->nodes, 0, 2 * sizeof(hl_node));
+    hl->nodes[0].result = hl->nodes[1].result = HL_NONE;
+    hl->used = 2;
+    hl->live = 0;
+    hl->freed = HL_NONE;
+    hl->table = NULL;
+    rehash(hl, 1024);
+    hl->limit = (size_t)capMB * 1024 * 1024 / (sizeof(hl_node) + 2 * sizeof(uint32_t));
+    hl->capMB = capMB;
+    hl->root = HL_NONE;
+    hl->collections = 0;
+    hl->restarts = 0;
+    hl->jumps = 0;
+    // the RESULT of level L is 2^(L-1) wide and has to cover the whole board
+    int need = 0;
+    while (((long)1 << need) < board->row || ((long)1 << need) < board->col) {
+        need++;
+    }
+    hl->minJump = (need + 1) - 2 > 0 ? (need + 1) - 2 : 0;
+    return hl;
+}
+
+/* hash_advance(gol_hash*, gol_board*, long);
+ * Advances a wrapped board by the biggest power of 2 generations that is no more than
+ * remaining and that a root can cover, in place. The node store is collected first if
+ * it has grown past the memory cap. A jump that fills the store to the cap is started
+ * again from an empty store, and halved if it fills it again.
+ * @param hl: the HashLife engine
+ * @param board: wrapped board, overwritten with the board 2^j generations later
+ * @param remaining: generations still to run
+ * @return: generations advanced, 0 if remaining is too small to jump (step it instead),
+ * -1 if even the smallest jump does not fit under the cap (the board is left as it was)
+ */
+long hash_advance(gol_hash* hl, gol_board* board, long remaining) {
+    // changed after setjmp, so kept out of registers the longjmp would restore
+    volatile int j = hl->minJump, emptied = 0;
+    if (remaining < ((long)1 << j)) {
+        return 0;
+    }
+    while (j < 62 && ((long)1 << (j + 1)) <= remaining) {
+        j++;
+    }
+    if (hl->live > hl->limit) {
+        collect(hl, hl->root);
+        if (hl->live > hl->limit / 2) {
+            collect(hl, HL_NONE);
+        }
+    }
+    if (setjmp(hl->full) != 0) {
+        // the store reached the cap mid jump, nodes still held by the recursion are
+        // gone with it, so everything but the leaves is dropped and the jump redone
+        if (emptied) {
+            if (j == hl->minJump) {
+                collect(hl, HL_NONE);
+                hl->root = HL_NONE;
+                return -1;
+            }
+            j--;
+        }
+        collect(hl, HL_NONE);
+        hl->root = HL_NONE;
+        hl->restarts++;
+        emptied = 1;
+    }
+    hl->root = build_root(hl, board, j + 2);
+    uint32_t res = result(hl, hl->root);
+
+    // the result starts 2^j cells in from the root's corner
+    long offr = pow2_mod(j, board->row), offc = pow2_mod(j, board->col);
+    for (int r = 0; r < board->row; r++) {
+        uint64_t y = (uint64_t)((r - offr + board->row) % board->row);
+        for (int c = 0; c < board->col; c++) {
+            uint64_t x = (uint64_t)((c - offc + board->col) % board->col);
+            set_cell(board, r, c, node_cell(hl, res, y, x));
+        }
+    }
+    hl->jumps++;
+    return (long)1 << j;
+}
+
+/* free_hash(gol_hash**);
+ * Frees the node store and the engine, and sets the caller's pointer to NULL
+ */
+void free_hash(gol_hash** phl) {
+    free((*phl)->nodes);
+    free((*phl)->table);
+    free((*phl)->grid);
+    free((*phl)->grid2);
+    free(*phl);
+    *phl = NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef GOL_HASH_H
+#define GOL_HASH_H
+
+#include <setjmp.h>
+#include "gol_board.h"
+
+// index used for "no node" (no memoized result yet, end of a hash chain)
+#define HL_NONE 0xFFFFFFFFu
+
+// one quadtree node, a square of 2^level cells on a side
+typedef struct hl_node {
+    uint32_t child[4];  // nw, ne, sw, se quadrants (unused for the two leaves)
+    uint32_t result;    // centre half, 2^(level-2) generations later (HL_NONE until known)
+    uint32_t next;      // next node in the same hash bucket, or in the free list
+    uint8_t level;      // 0 for the dead (index 0) and live (index 1) leaf cells
+    uint8_t mark;       // set while collecting garbage, 0xFF for a freed node
+} hl_node;
+
+// hash-consed quadtree store for the HashLife engine
+typedef struct gol_hash {
+    hl_node* nodes;     // every node, children are indices into this array
+    uint32_t used;      // slots of nodes handed out so far
+    uint32_t slots;     // slots allocated
+    uint32_t live;      // nodes in use (used minus the free list)
+    uint32_t freed;     // head of the free list
+    uint32_t* table;    // hash buckets, each the head of a chain through next
+    uint32_t buckets;   // number of buckets, a power of 2
+    size_t limit;       // node count allowed by the memory cap
+    long capMB;         // the cap, from -m
+    jmp_buf full;       // where a jump is given up when the store reaches the cap
+    uint32_t root;      // last root built, kept alive by collections
+    uint32_t* grid;     // one node per board cell while building a root
+    uint32_t* grid2;
+    int minJump;        // smallest log2 jump whose result still covers the board
+    int collections;    // garbage collections run so far
+    int restarts;       // jumps given up at the cap and started again
+    long jumps;         // jumps made so far
+} gol_hash;
+
+gol_hash* create_hash(const gol_board*, long);
+long hash_advance(gol_hash*, gol_board*, long);
+void free_hash(gol_hash**);
+
+#endif
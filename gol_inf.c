@@ -0,0 +1,260 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_inf.c
+ * This file is the infinite topology. The board has no edge at all: live cells are kept
+ * in 64x64 chunks stored in a hash table keyed by 64-bit chunk coordinates, and a chunk
+ * only exists while it (or a neighbour next to its edge) has live cells. A glider flying
+ * off for a billion generations costs the chunks around it and nothing else, so memory
+ * follows the live population rather than the size of the region it covers. The row x col
+ * board from the input file is only the window that gets printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_inf.h"
+#include "gol_swar.h"
+
+/* hash_key(int64_t, int64_t);
+ * @return: hash of a chunk coordinate
+ */
+static inline uint32_t hash_key(int64_t cy, int64_t cx) {
+    uint64_t h = (uint64_t)cy * 0x9E3779B97F4A7C15ull ^ (uint64_t)cx * 0xC2B2AE3D27D4EB4Full;
+    return (uint32_t)((h ^ (h >> 29)) * 0x165667B19E3779F9ull >> 32);
+}
+
+/* find_chunk(const gol_inf*, int64_t, int64_t);
+ * @return: index of the chunk at cy, cx or -1 if it doesn't exist
+ */
+static int find_chunk(const gol_inf* inf, int64_t cy, int64_t cx) {
+    for (int32_t i = inf->table[hash_key(cy, cx) & (inf->buckets - 1)]; i != -1; i = inf->chunks[i].next) {
+        if (inf->chunks[i].cy == cy && inf->chunks[i].cx == cx) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* rebuild_table(gol_inf*);
+ * Re-links every chunk into a bucket table with at least as many buckets as chunks.
+ */
+static void rebuild_table(gol_inf* inf) {
+    int buckets = 64;
+    while (buckets < inf->count) {
+        buckets *= 2;
+    }
+    if (buckets != inf->buckets) {
+        free(inf->table);
+        inf->table = malloc(buckets * sizeof(int32_t));
+        if (inf->table == NULL) {
+            printf("error: unable to allocate a table of %d chunks\n", buckets);
+            exit(-1);
+        }
+        inf->buckets = buckets;
+    }
+    memset(inf->table, 0xFF, buckets * sizeof(int32_t));
+    for (int i = 0; i < inf->count; i++) {
+        uint32_t b = hash_key(inf->chunks[i].cy, inf->chunks[i].cx) & (buckets - 1);
+        inf->chunks[i].next = inf->table[b];
+        inf->table[b] = i;
+    }
+}
+
+/* get_chunk(gol_inf*, int64_t, int64_t);
+ * @return: index of the chunk at cy, cx, creating an empty one if needed
+ */
+static int get_chunk(gol_inf* inf, int64_t cy, int64_t cx) {
+    int i = find_chunk(inf, cy, cx);
+    if (i != -1) {
+        return i;
+    }
+    if (inf->count == inf->slots) {
+        // kept apart so a failure still has the old chunks to report
+        inf_chunk* grown = realloc(inf->chunks, (size_t)inf->slots * 2 * sizeof(inf_chunk));
+        if (grown == NULL) {
+            printf("error: unable to grow the plane past %d chunks\n", inf->slots);
+            exit(-1);
+        }
+        inf->chunks = grown;
+        inf->slots *= 2;
+    }
+    i = inf->count++;
+    memset(&inf->chunks[i], 0, sizeof(inf_chunk));
+    inf->chunks[i].cy = cy;
+    inf->chunks[i].cx = cx;
+    if (inf->count > inf->buckets) {
+        rebuild_table(inf);
+    }
+    else {
+        uint32_t b = hash_key(cy, cx) & (inf->buckets - 1);
+        inf->chunks[i].next = inf->table[b];
+        inf->table[b] = i;
+    }
+    return i;
+}
+
+/* create_inf(const gol_board*);
+ * Create inf copies the live cells of a board onto the unbounded plane, with the board's
+ * cell 0, 0 at plane coordinate 0, 0.
+ * @param board: the board read from the input file
+ * @return: the unbounded board
+ */
+gol_inf* create_inf(const gol_board* board) {
+    gol_inf* inf = malloc(sizeof(gol_inf));
+    inf_chunk* chunks = malloc(64 * sizeof(inf_chunk));
+    if (inf == NULL || chunks == NULL) {
+        printf("error: unable to allocate the unbounded plane\n");
+        exit(-1);
+    }
+    inf->slots = 64;
+    inf->chunks = chunks;
+    inf->count = 0;
+    inf->table = NULL;
+    inf->buckets = 0;
+    inf->gen = 0;
+    rebuild_table(inf);
+    for (int r = 0; r < board->row; r++) {
+        for (int c = 0; c < board->col; c++) {
+            if (get_cell(board, r, c)) {
+                int i = get_chunk(inf, r / CHUNK_SIZE, c / CHUNK_SIZE);
+                inf->chunks[i].cells[0][r % CHUNK_SIZE] |= (uint64_t)1 << (c % CHUNK_SIZE);
+            }
+        }
+    }
+    return inf;
+}
+
+/* grow_edges(gol_inf*);
+ * Creates the neighbours of every chunk that has live cells on the matching edge or
+ * corner, the only places births can spill into next generation.
+ */
+static void grow_edges(gol_inf* inf) {
+    int p = inf->gen & 1, n = inf->count;
+    for (int i = 0; i < n; i++) {
+        const uint64_t* c = inf->chunks[i].cells[p];
+        uint64_t west = 0, east = 0;
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            west |= c[r] & 1;
+            east |= c[r] >> 63;
+        }
+        int64_t cy = inf->chunks[i].cy, cx = inf->chunks[i].cx;
+        // adding a chunk can move chunk i (and c), so read everything needed first
+        int wants[8] = {c[0] != 0, c[CHUNK_SIZE-1] != 0,
+                        west != 0, east != 0, (int)(c[0] & 1), (int)(c[0] >> 63),
+                        (int)(c[CHUNK_SIZE-1] & 1), (int)(c[CHUNK_SIZE-1] >> 63)};
+        int64_t dy[8] = {-1, 1, 0, 0, -1, -1, 1, 1}, dx[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+        for (int d = 0; d < 8; d++) {
+            if (wants[d]) {
+                get_chunk(inf, cy + dy[d], cx + dx[d]);
+            }
+        }
+    }
+}
+
+/* chunk_rows(const gol_inf*, const int*, int, uint64_t*);
+ * Fills three words with row r of the chunks west of, at, and east of a chunk. Row -1
+ * and row 64 come from the chunks above and below. Missing chunks are dead.
+ * @param nb: the 3x3 block of chunk indices around the chunk, row major, -1 if missing
+ */
+static void chunk_rows(const gol_inf* inf, const int* nb, int r, uint64_t* out) {
+    int p = inf->gen & 1;
+    int band = (r < 0) ? 0 : (r >= CHUNK_SIZE) ? 6 : 3;
+    int rr = (r + CHUNK_SIZE) % CHUNK_SIZE;
+    for (int k = 0; k < 3; k++) {
+        out[k] = (nb[band + k] != -1) ? inf->chunks[nb[band + k]].cells[p][rr] : 0;
+    }
+}
+
+/* inf_step(gol_inf*);
+ * Steps the unbounded board one generation: grow chunks where births can spill over,
+ * step every chunk with swar_word (three word rows, no wrap), then drop chunks that
+ * ended up empty.
+ */
+void inf_step(gol_inf* inf) {
+    int p = inf->gen & 1;
+    grow_edges(inf);
+    for (int i = 0; i < inf->count; i++) {
+        int nb[9];
+        for (int k = 0; k < 9; k++) {
+            nb[k] = find_chunk(inf, inf->chunks[i].cy + k / 3 - 1, inf->chunks[i].cx + k % 3 - 1);
+        }
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            uint64_t up[3], mid[3], dn[3];
+            chunk_rows(inf, nb, r - 1, up);
+            chunk_rows(inf, nb, r, mid);
+            chunk_rows(inf, nb, r + 1, dn);
+            inf->chunks[i].cells[!p][r] = swar_word(up, mid, dn, 1, 3 * CHUNK_SIZE, 0, &golRule);
+        }
+    }
+    inf->gen++;
+
+    // keep only chunks with live cells, packed to the front
+    int kept = 0;
+    for (int i = 0; i < inf->count; i++) {
+        uint64_t any = 0;
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            any |= inf->chunks[i].cells[!p][r];
+        }
+        if (any != 0) {
+            inf->chunks[kept++] = inf->chunks[i];
+        }
+    }
+    inf->count = kept;
+    rebuild_table(inf);
+}
+
+/* inf_window(const gol_inf*, gol_board*);
+ * Copies the part of the plane covered by the board (rows 0 to row-1, columns 0 to
+ * col-1) into the board, so it can be printed.
+ */
+void inf_window(const gol_inf* inf, gol_board* board) {
+    int p = inf->gen & 1;
+    for (int r = 0; r < board->row; r++) {
+        const inf_chunk* ch = NULL;
+        int64_t lastCx = -1;
+        for (int c = 0; c < board->col; c++) {
+            if (c / CHUNK_SIZE != lastCx) {
+                lastCx = c / CHUNK_SIZE;
+                int i = find_chunk(inf, r / CHUNK_SIZE, lastCx);
+                ch = (i != -1) ? &inf->chunks[i] : NULL;
+            }
+            int alive = ch != NULL && ((ch->cells[p][r % CHUNK_SIZE] >> (c % CHUNK_SIZE)) & 1);
+            set_cell(board, r, c, alive);
+        }
+    }
+}
+
+/* inf_population(const gol_inf*, int64_t*);
+ * Counts live cells and finds the bounding box of the live region.
+ * @param box: filled with top row, left column, bottom row, right column (if any live)
+ * @return: number of live cells
+ */
+long inf_population(const gol_inf* inf, int64_t* box) {
+    int p = inf->gen & 1;
+    long pop = 0;
+    for (int i = 0; i < inf->count; i++) {
+        const inf_chunk* ch = &inf->chunks[i];
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            uint64_t w = ch->cells[p][r];
+            if (w == 0) {
+                continue;
+            }
+            int64_t y = ch->cy * CHUNK_SIZE + r;
+            int64_t x0 = ch->cx * CHUNK_SIZE + __builtin_ctzll(w);
+            int64_t x1 = ch->cx * CHUNK_SIZE + 63 - __builtin_clzll(w);
+            box[0] = (pop == 0 || y < box[0]) ? y : box[0];
+            box[1] = (pop == 0 || x0 < box[1]) ? x0 : box[1];
+            box[2] = (pop == 0 || y > box[2]) ? y : box[2];
+            box[3] = (pop == 0 || x1 > box[3]) ? x1 : box[3];
+            pop += __builtin_popcountll(w);
+        }
+    }
+    return pop;
+}
+
+/* free_inf(gol_inf**);
+ * Frees every chunk and the table, and sets the caller's pointer to NULL
+ */
+void free_inf(gol_inf** pinf) {
+    free((*pinf)->chunks);
+    free((*pinf)->table);
+    free(*pinf);
+    *pinf = NULL;
+}
@@ -0,0 +1,33 @@
+#ifndef GOL_INF_H
+#define GOL_INF_H
+
+#include "gol_board.h"
+
+// a chunk is CHUNK_SIZE x CHUNK_SIZE cells, one word per row
+#define CHUNK_SIZE 64
+
+// one chunk of the unbounded plane, only kept while it has live cells (or a live neighbour)
+typedef struct inf_chunk {
+    int64_t cy;                     // chunk row, cells cy * 64 up to cy * 64 + 63
+    int64_t cx;                     // chunk column
+    uint64_t cells[2][CHUNK_SIZE];  // this generation and the next, picked by gen parity
+    int32_t next;                   // next chunk in the same hash bucket
+} inf_chunk;
+
+// unbounded board: live chunks kept in a hash table keyed by 64-bit chunk coordinates
+typedef struct gol_inf {
+    inf_chunk* chunks;  // every chunk that exists, in no particular order
+    int count;          // chunks in use
+    int slots;          // chunks allocated
+    int32_t* table;     // hash buckets, heads of chains through next
+    int buckets;        // number of buckets, a power of 2
+    long gen;           // generations stepped so far
+} gol_inf;
+
+gol_inf* create_inf(const gol_board*);
+void inf_step(gol_inf*);
+void inf_window(const gol_inf*, gol_board*);
+long inf_population(const gol_inf*, int64_t*);
+void free_inf(gol_inf**);
+
+#endif
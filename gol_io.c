@@ -7,91 +7,515 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "gol_io.h"
 
-/* read_file(char*, int*, int*, int*);
- * Read file opens a file pointer to a valid input file (see check_file for validation).
- * The number of rows, cols, and iterations for the simulation are read in from the first
- * three lines of the file. The int* passed into the function point to these values so they
- * can be later referenced and used back in main. A 2D board array is allocated and data
- * is read in line by line until end of file (see create_empty_board for more details).
- * Then, the board is returned (int**)
- * @param filename: the string containing the name of the user input file
+/* skip_blank(const char**, const char*);
+ * Moves the scan position past spaces, tabs and line breaks.
+ * @param p: pointer to the current scan position
+ * @param end: one past the last byte of the file
+ * @return: 1 if there is anything left to read, 0 at end of file
+*/
+static int skip_blank(const char** p, const char* end) {
+    while (*p < end && (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r')) {
+        (*p)++;
+    }
+    return *p < end;
+}
+
+/* skip_line(const char**, const char*);
+ * Moves the scan position to the start of the next line.
+ * @param p: pointer to the current scan position
+ * @param end: one past the last byte of the file
+*/
+static void skip_line(const char** p, const char* end) {
+    const char* nl = memchr(*p, '\n', end - *p);
+    *p = nl ? nl + 1 : end;
+}
+
+/* scan_long(const char**, const char*, long*);
+ * Reads one (optionally negative) decimal integer at the scan position after skipping
+ * blanks. Replaces fscanf: no locale or format string, and values that do not fit in
+ * a long are refused rather than wrapped.
+ * @param p: pointer to the current scan position, moved past the number
+ * @param end: one past the last byte of the file
+ * @param out: where the value is stored
+ * @return: 1 if a number was read, 0 if the next text is not a number
+*/
+static int scan_long(const char** p, const char* end, long* out) {
+    if (!skip_blank(p, end)) {
+        return 0;
+    }
+    const char* s = *p;
+    int neg = (*s == '-');
+    if (neg) {
+        s++;
+    }
+    if (s == end || *s < '0' || *s > '9') {
+        return 0;
+    }
+    long val = 0;
+    while (s < end && *s >= '0' && *s <= '9') {
+        // refuse anything that would overflow a long
+        if (val > (LONG_MAX - (*s - '0')) / 10) {
+            return 0;
+        }
+        val = val * 10 + (*s - '0');
+        s++;
+    }
+    *out = neg ? -val : val;
+    *p = s;
+    return 1;
+}
+
+// the one problem that is not in the pattern itself (see place_board)
+static const char noRoom[] = "board is larger than the room for it";
+
+/* load_error(gol_load_error*, const char*, const char*, const char*);
+ * Records which line a load failed on and why.
+ * @param err: where the problem is stored
+ * @param base: first byte of the pattern
+ * @param at: scan position where the problem was found
+ * @param what: description of the problem
+ * @return: NULL, so a loader can return it
+*/
+static gol_board* load_error(gol_load_error* err, const char* base, const char* at, const char* what) {
+    int line = 1;
+    for (const char* s = base; s < at; s++) {
+        line += (*s == '\n');
+    }
+    err->line = line;
+    err->what = what;
+    err->room = (what == noRoom);
+    return NULL;
+}
+
+/* load_fail(gol_board*, gol_board*, gol_load_error*, const char*, const char*, const char*);
+ * load_error for a problem found after the board was placed. A board made for this
+ * pattern is freed, a spare is left to its owner.
+ * @return: NULL
+*/
+static gol_board* load_fail(gol_board* board, gol_board* spare, gol_load_error* err, const char* base,
+                            const char* at, const char* what) {
+    if (board != spare) {
+        free(board->cells);
+        free(board);
+    }
+    return load_error(err, base, at, what);
+}
+
+/* size_ok(long, long);
+ * @return: 1 if a board size read from a pattern is usable, 0 otherwise
+*/
+static int size_ok(long rows, long cols) {
+    return rows >= 1 && cols >= 1 && rows <= GOL_MAX_SIDE && cols <= GOL_MAX_SIDE;
+}
+
+/* place_board(gol_board*, int, int, int);
+ * Gives the empty board a pattern is decoded into: spare when it can hold it (see
+ * reuse_board), otherwise a new board if grow is set and NULL if not.
+*/
+static gol_board* place_board(gol_board* spare, int row, int col, int grow) {
+    if (grow) {
+        return reuse_board(spare, row, col);
+    }
+    gol_board shape;
+    if (spare == NULL || board_layout(&shape, row, col) > spare->bytes) {
+        return NULL;
+    }
+    return reuse_board(spare, row, col);
+}
+
+/* set_run(gol_board*, int, int, int);
+ * Turns on n cells of row r starting at column c, a word at a time.
+*/
+static void set_run(gol_board* board, int r, int c, int n) {
+    uint64_t* row = board_row(board, r);
+    while (n > 0) {
+        int bit = c % GOL_WORD_BITS;
+        int take = GOL_WORD_BITS - bit < n ? GOL_WORD_BITS - bit : n;
+        uint64_t bits = take == GOL_WORD_BITS ? ~0ULL : ((1ULL << take) - 1) << bit;
+        row[c / GOL_WORD_BITS] |= bits;
+        c += take;
+        n -= take;
+    }
+}
+
+/* load_plain(const char*, const char*, gol_board*, int, int*, int*, long*, gol_load_error*);
+ * The original format: rows, cols and iterations, then one "row col" pair per live cell.
+ * Every pair is checked against the board size before it is set.
+*/
+static gol_board* load_plain(const char* p, const char* end, gol_board* spare, int grow,
+                             int* prow, int* pcol, long* psim, gol_load_error* err) {
+    const char* base = p;
+    long rows, cols, iters;
+    if (!scan_long(&p, end, &rows) || !scan_long(&p, end, &cols) || !scan_long(&p, end, &iters)) {
+        return load_error(err, base, p, "expected rows, cols and iterations");
+    }
+    if (!size_ok(rows, cols)) {
+        return load_error(err, base, p, "board size must be between 1 and 2^30 on each side");
+    }
+    if (iters < 0) {
+        return load_error(err, base, p, "number of iterations can not be negative");
+    }
+    gol_board* board = place_board(spare, rows, cols, grow);
+    if (board == NULL) {
+        return load_error(err, base, p, noRoom);
+    }
+
+    long r, c;
+    while (skip_blank(&p, end)) {
+        if (!scan_long(&p, end, &r) || !scan_long(&p, end, &c)) {
+            return load_fail(board, spare, err, base, p, "expected a \"row col\" pair");
+        }
+        if (r < 0 || r >= rows || c < 0 || c >= cols) {
+            return load_fail(board, spare, err, base, p, "cell lies outside the board");
+        }
+        set_cell(board, r, c, 1);
+    }
+    *prow = rows;
+    *pcol = cols;
+    *psim = iters;
+    return board;
+}
+
+/* load_rle(const char*, const char*, gol_board*, int, int*, int*, long*, gol_load_error*);
+ * Run length encoded patterns: '#' comment lines, an "x = cols, y = rows" header (any
+ * rule given there is ignored), then runs of 'b' (dead), 'o' (alive) and '$' (end of row)
+ * up to '!'. Runs are decoded straight into the board a word at a time. Letters other
+ * than 'b' are multi-state cells and are read as alive. A run or row skip that goes past
+ * the header's size, or a count that does not fit in an int, is an error. RLE carries
+ * no iteration count, so *psim is set to -1 (see -n in gol_cmd.c).
+*/
+static gol_board* load_rle(const char* p, const char* end, gol_board* spare, int grow,
+                           int* prow, int* pcol, long* psim, gol_load_error* err) {
+    const char* base = p;
+    // comments
+    while (skip_blank(&p, end) && *p == '#') {
+        skip_line(&p, end);
+    }
+    // header, x is the width and y the height
+    long cols, rows;
+    if (p == end || *p++ != 'x' || !skip_blank(&p, end) || *p++ != '=' || !scan_long(&p, end, &cols) ||
+        !skip_blank(&p, end) || *p++ != ',' || !skip_blank(&p, end) || *p++ != 'y' ||
+        !skip_blank(&p, end) || *p++ != '=' || !scan_long(&p, end, &rows)) {
+        return load_error(err, base, p, "expected an RLE header \"x = <cols>, y = <rows>\"");
+    }
+    if (!size_ok(rows, cols)) {
+        return load_error(err, base, p, "board size must be between 1 and 2^30 on each side");
+    }
+    skip_line(&p, end);
+    gol_board* board = place_board(spare, rows, cols, grow);
+    if (board == NULL) {
+        return load_error(err, base, p, noRoom);
+    }
+
+    long r = 0, c = 0;
+    while (skip_blank(&p, end) && *p != '!') {
+        long n = 1;
+        if (*p >= '0' && *p <= '9' && (!scan_long(&p, end, &n) || n < 1 || n > INT_MAX || p == end)) {
+            return load_fail(board, spare, err, base, p, "bad run length");
+        }
+        char tag = *p++;
+        // the cursor may end up just past the last row or col, never further
+        if (tag == '$') {
+            if (n > rows - r) {
+                return load_fail(board, spare, err, base, p, "rows go past the y size in the header");
+            }
+            r += n;
+            c = 0;
+        }
+        else if (tag == 'b') {
+            if (n > cols - c) {
+                return load_fail(board, spare, err, base, p, "run goes past the x/y size in the header");
+            }
+            c += n;
+        }
+        else if ((tag >= 'a' && tag <= 'z') || (tag >= 'A' && tag <= 'Z')) {
+            if (r >= rows || c + n > cols) {
+                return load_fail(board, spare, err, base, p, "run goes past the x/y size in the header");
+            }
+            set_run(board, r, c, n);
+            c += n;
+        }
+        else {
+            return load_fail(board, spare, err, base, p - 1, "unexpected character in RLE data");
+        }
+    }
+    *prow = rows;
+    *pcol = cols;
+    *psim = -1;
+    return board;
+}
+
+/* load_life106(const char*, const char*, gol_board*, int, int*, int*, long*, gol_load_error*);
+ * Life 1.06: a "#Life 1.06" line, then one "x y" pair per live cell with no board
+ * size. A first pass finds the bounding box and a second pass sets the cells, so the
+ * board is exactly as large as the pattern. No iteration count, *psim is set to -1.
+*/
+static gol_board* load_life106(const char* p, const char* end, gol_board* spare, int grow,
+                               int* prow, int* pcol, long* psim, gol_load_error* err) {
+    const char* base = p;
+    skip_line(&p, end);
+    const char* cells = p;
+
+    // pass one, bounding box
+    long x, y;
+    long minX = 0, maxX = 0, minY = 0, maxY = 0;
+    int any = 0;
+    while (skip_blank(&p, end)) {
+        if (*p == '#') {
+            skip_line(&p, end);
+            continue;
+        }
+        if (!scan_long(&p, end, &x) || !scan_long(&p, end, &y)) {
+            return load_error(err, base, p, "expected an \"x y\" pair");
+        }
+        if (labs(x) > GOL_MAX_SIDE || labs(y) > GOL_MAX_SIDE) {
+            return load_error(err, base, p, "cell lies too far from the origin");
+        }
+        if (!any || x < minX) minX = x;
+        if (!any || x > maxX) maxX = x;
+        if (!any || y < minY) minY = y;
+        if (!any || y > maxY) maxY = y;
+        any = 1;
+    }
+    if (!size_ok(maxY - minY + 1, maxX - minX + 1)) {
+        return load_error(err, base, p, "board size must be between 1 and 2^30 on each side");
+    }
+    gol_board* board = place_board(spare, maxY - minY + 1, maxX - minX + 1, grow);
+    if (board == NULL) {
+        return load_error(err, base, p, noRoom);
+    }
+
+    // pass two, every pair was checked above
+    p = cells;
+    while (skip_blank(&p, end)) {
+        if (*p == '#') {
+            skip_line(&p, end);
+            continue;
+        }
+        scan_long(&p, end, &x);
+        scan_long(&p, end, &y);
+        set_cell(board, y - minY, x - minX, 1);
+    }
+    *prow = board->row;
+    *pcol = board->col;
+    *psim = -1;
+    return board;
+}
+
+/* parse_pattern(const char*, size_t, gol_board*, int, int*, int*, long*, gol_load_error*);
+ * Parse pattern decodes a pattern held in memory straight into a packed board. The
+ * format is picked from the first text: "#Life 1.06" is Life 1.06, '#' or 'x' starts an
+ * RLE pattern, and anything else is the original format (see README). The number of
+ * rows, cols and iterations are returned by reference; formats that do not store an
+ * iteration count return -1. Nothing is printed and nothing exits, so the library
+ * (gol_lib.c) can load patterns too.
+ * @param text: the pattern, not necessarily 0 terminated
+ * @param len: its length in bytes
+ * @param spare: board whose cell buffer may be reused (see reuse_board), NULL for a new board
+ * @param grow: 1 to make a new board when spare is too small, 0 to fail instead
  * @param prow: pointer to the integer storing number of rows for the board
  * @param pcol: pointer to the integer storing number of cols for the board
- * @param psim: pointer to the integer storing number of iterations for the simulation
- * @return: 2D int array storing all the board information from the input file
+ * @param psim: pointer to the long storing number of iterations for the simulation
+ * @param err: line and description of the problem when NULL is returned
+ * @return: the board (spare itself when it was large enough), or NULL if the pattern is
+ * malformed or, without grow, does not fit in spare
 */
-int** read_file(char* filename, int* prow, int* pcol, int* psim) {
-     // open file to read, know it's valid from earlier cmd line parse check
-    FILE* infile = fopen(filename, "r");
+gol_board* parse_pattern(const char* text, size_t len, gol_board* spare, int grow,
+                         int* prow, int* pcol, long* psim, gol_load_error* err) {
+    const char* end = text + len;
+    const char* p = text;
+    skip_blank(&p, end);
+    size_t left = end - p;
+    if (left >= 10 && memcmp(p, "#Life 1.06", 10) == 0) {
+        return load_life106(p, end, spare, grow, prow, pcol, psim, err);
+    }
+    if (left > 0 && (*p == '#' || *p == 'x')) {
+        return load_rle(p, end, spare, grow, prow, pcol, psim, err);
+    }
+    return load_plain(p, end, spare, grow, prow, pcol, psim, err);
+}
 
-    // read in top three values from file
-    fscanf(infile, "%d\n", prow);
-    fscanf(infile, "%d\n", pcol);
-    fscanf(infile, "%d\n", psim);
+/* load_file(const char*, gol_board*, int*, int*, long*, gol_load_error*);
+ * Load file maps the input file into memory in one call and decodes it with
+ * parse_pattern, with no stdio buffering or per-line fscanf. Nothing is printed and
+ * nothing exits, so batch workers (gol_batch.c) can go on after a bad file.
+ * @param filename: the string containing the name of the user input file
+ * @param spare: board whose cell buffer may be reused (see reuse_board), NULL for a new board
+ * @param prow: pointer to the integer storing number of rows for the board
+ * @param pcol: pointer to the integer storing number of cols for the board
+ * @param psim: pointer to the long storing number of iterations for the simulation
+ * @param err: line and description of the problem when NULL is returned, line 0 when
+ * the file itself could not be read
+ * @return: the board (spare itself when it was large enough), or NULL
+*/
+gol_board* load_file(const char* filename, gol_board* spare, int* prow, int* pcol, long* psim,
+                     gol_load_error* err) {
+    err->line = 0;
+    err->room = 0;
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        err->what = "is an invalid file";
+        return NULL;
+    }
+    if (info.st_size == 0) {
+        close(fd);
+        err->what = "is empty";
+        return NULL;
+    }
+    const char* text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping holds its own reference to the file
+    close(fd);
+    if (text == MAP_FAILED) {
+        err->what = "could not be mapped";
+        return NULL;
+    }
+    // read front to back once, let the kernel read ahead
+    madvise((void*)text, info.st_size, MADV_SEQUENTIAL);
 
-    // create an empty board
-    // board = create_empty_board(*prow, *pcol);
-    int** tempBoard = create_empty_board(*prow, *pcol);
+    gol_board* board = parse_pattern(text, info.st_size, spare, 1, prow, pcol, psim, err);
+    munmap((void*)text, info.st_size);
+    return board;
+}
 
-    int tempRow, tempCol;
-    // while the line of the file you read has exactly two data items
-    while (fscanf(infile, "%d %d\n", &tempRow, &tempCol) == 2) {
-        tempBoard[tempRow][tempCol] = 1;
+/* read_file(char*, gol_board*, int*, int*, long*);
+ * Read file loads the input file with load_file. Formats that do not store an
+ * iteration count return -1 and the count comes from the -n option instead.
+ * Any malformed number or out of range cell is reported with its line and the program
+ * exits.
+ * @param filename: the string containing the name of the user input file
+ * @param spare: board whose cell buffer may be reused (see reuse_board), NULL for a new board
+ * @param prow: pointer to the integer storing number of rows for the board
+ * @param pcol: pointer to the integer storing number of cols for the board
+ * @param psim: pointer to the long storing number of iterations for the simulation
+ * @return: packed board storing all the board information from the input file, spare
+ * itself when it was large enough
+*/
+gol_board* read_file(char* filename, gol_board* spare, int* prow, int* pcol, long* psim) {
+    gol_load_error err;
+    gol_board* board = load_file(filename, spare, prow, pcol, psim, &err);
+    if (board == NULL && err.line == 0) {
+        printf("error: '%s' %s\n", filename, err.what);
+        printf("ensure file exists and entered correctly\n\n");
+        exit(-1);
     }
+    if (board == NULL) {
+        printf("error: '%s' line %d: %s\n\n", filename, err.line, err.what);
+        exit(-1);
+    }
+    return board;
+}
 
-    // close file pointer
-    fclose(infile);
-    // return int** (2d) board array
-    return tempBoard;
+/* board_layout(gol_board*, int, int);
+ * Sets the size and row layout of a ROWxCOL board.
+ * @return: bytes its cells take, the dead row included
+*/
+size_t board_layout(gol_board* board, int row, int col) {
+    board->row = row;
+    board->col = col;
+    // number of words needed to hold col bits
+    board->words = (col + GOL_WORD_BITS - 1) / GOL_WORD_BITS;
+    // round the row up to a whole number of cache lines
+    int lineWords = GOL_ALIGN / sizeof(uint64_t);
+    board->stride = (board->words + lineWords - 1) / lineWords * lineWords;
+    return (size_t)(row + 1) * board->stride * sizeof(uint64_t);
 }
 
 /* create_empty_board(int, int)
- * Create empty board takes in dimension input for a ROWxCOL grid, 2D array.
- * A double for loop initializes and allocates the board, filling every grid
- * position with 0's.
+ * Create empty board takes in dimension input for a ROWxCOL grid. Every cell is stored
+ * as one bit, and all rows live in one contiguous buffer aligned to GOL_ALIGN. Each row
+ * is padded to a whole number of cache lines so row r always starts on a line boundary.
+ * The buffer is zeroed in one go, so every cell (and every padding bit) starts as 0.
+ * An extra row past the last one is allocated and left dead (see gol_board.h).
  * @param: integer value storing number of rows for the board
  * @param: integer value storing number of cols for the board
- * @return: int** of the 2D int array storing the empty board (RxC) of all 0's
-*/
-int** create_empty_board(int row, int col) {
-    // create board with empty 0's with given row x col
-    int** tempBoard = malloc(row * sizeof(int*));
-    for(int r = 0; r < row; r++) {
-        // loop through and create array at each pointer in tempBoard
-        int* temp = malloc(col * sizeof(int));
-        // fill the array with 0's
-        for(int c = 0; c < col; c++) {
-            temp[c] = 0;
-        }
-        // put temp array at row r
-        tempBoard[r] = temp;
+ * @return: gol_board* storing the empty board (RxC) of all 0's
+*/
+gol_board* create_empty_board(int row, int col) {
+    gol_board* tempBoard = malloc(sizeof(gol_board));
+    size_t bytes = board_layout(tempBoard, row, col);
+
+    // one aligned allocation for every row plus the dead row, filled with 0's
+    if (posix_memalign((void**)&tempBoard->cells, GOL_ALIGN, bytes) != 0) {
+        printf("error: unable to allocate a %dx%d board\n", row, col);
+        exit(-1);
     }
+    memset(tempBoard->cells, 0, bytes);
+    tempBoard->bytes = bytes;
+    // the cells are owned by this board, not by a mapping
+    tempBoard->map = NULL;
+    tempBoard->mapBytes = 0;
+    tempBoard->arena = NULL;
+    tempBoard->hashes = NULL;
+#ifdef GOL_STATS
+    tempBoard->counts = NULL;
+#endif
     // return board
     return tempBoard;
 }
 
-/* print_board(int**, int, int);
- * Print board takes in a int** 2D array (board), along with its dimensions
- * to output to the user. The board is coded using 0/1's integers but the output
- * will be done using some characters to enhance the output experience. 
- * 0 = '-' and 1 = '@'
- * @param: int** storing the 2D integer array board
- * @param: integer value storing number of rows for the board
- * @param: integer value storing number of cols for the board
+/* reuse_board(gol_board*, int, int);
+ * Reuse board gives an empty ROWxCOL board like create_empty_board, but lays it out in
+ * the cell buffer of spare when that buffer is large enough, so boards of a batch can
+ * share a few buffers instead of allocating one each.
+ * @param spare: board that is no longer needed, or NULL
+ * @param row: number of rows
+ * @param col: number of cols
+ * @return: spare holding the empty board, or a new board when spare is NULL, mapped,
+ * in an arena or too small (spare is then left as it was)
+*/
+gol_board* reuse_board(gol_board* spare, int row, int col) {
+    gol_board shape;
+    size_t bytes = board_layout(&shape, row, col);
+    if (spare == NULL || spare->map != NULL || spare->arena != NULL || bytes > spare->bytes) {
+        return create_empty_board(row, col);
+    }
+    board_layout(spare, row, col);
+    memset(spare->cells, 0, bytes);
+    return spare;
+}
+
+/* write_rows(FILE*, const gol_board*, int, int);
+ * Write rows writes rows r0 up to (not including) r1 of the board the way print_board
+ * shows them, one line per row. Each row is built in a buffer and written with one fwrite.
+ * @param out: stream to write to
+ * @param board: packed board to write
+ * @param r0: first row
+ * @param r1: one past the last row
  */
-void print_board(int** board, int row, int col) {
-    // loop through each data item (either a 0 or 1)
-    for (int r = 0; r < row; r++) {
-        // if grid cell data is 1, print @, else print -
-        for (int c = 0; c < col; c++) {
-            if (board[r][c] == 1)
-                printf("%c", '@');
-            else
-                printf("%c", '-');
+void write_rows(FILE* out, const gol_board* board, int r0, int r1) {
+    char* line = malloc(board->col + 1);
+    // loop through each cell (either a 0 or 1)
+    for (int r = r0; r < r1; r++) {
+        // if grid cell is alive, store @, else store -
+        for (int c = 0; c < board->col; c++) {
+            line[c] = get_cell(board, r, c) == 1 ? '@' : '-';
         }
-        printf("\n");
+        line[board->col] = '\n';
+        fwrite(line, 1, board->col + 1, out);
     }
+    free(line);
+}
+
+/* print_board(const gol_board*);
+ * Print board takes in a packed board (which knows its own dimensions)
+ * to output to the user. The board is coded using 0/1 bits but the output
+ * will be done using some characters to enhance the output experience. 
+ * 0 = '-' and 1 = '@'
+ * @param board: packed board to print
+ */
+void print_board(const gol_board* board) {
+    write_rows(stdout, board, 0, board->row);
     printf("\n");
-}
\ No newline at end of file
+}
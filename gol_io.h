@@ -1,3 +1,21 @@
-int** read_file(char*, int*, int*, int*);
-int** create_empty_board(int, int);
-void print_board(int**, int, int);
\ No newline at end of file
+#include <stdio.h>
+#include "gol_board.h"
+
+// largest number of rows or columns a pattern file may ask for
+#define GOL_MAX_SIDE (1L << 30)
+
+// where and why a pattern could not be loaded (see parse_pattern)
+typedef struct gol_load_error {
+    int line;           // line of the pattern the problem is on, from 1
+    const char* what;   // description of the problem
+    int room;           // 1 if the pattern is fine but spare was too small for it
+} gol_load_error;
+
+gol_board* parse_pattern(const char*, size_t, gol_board*, int, int*, int*, long*, gol_load_error*);
+gol_board* load_file(const char*, gol_board*, int*, int*, long*, gol_load_error*);
+gol_board* read_file(char*, gol_board*, int*, int*, long*);
+gol_board* create_empty_board(int, int);
+size_t board_layout(gol_board*, int, int);
+gol_board* reuse_board(gol_board*, int, int);
+void write_rows(FILE*, const gol_board*, int, int);
+void print_board(const gol_board*);
\ No newline at end of file
@@ -0,0 +1,386 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_lib.c
+ * This file is the library behind gol_lib.h. An engine is two boards stepped into each
+ * other with the widest row kernel the CPU has, the same way simulate_board steps them
+ * on one thread. gol_create reserves room for the largest board the engine will hold;
+ * every later call works inside that room, so nothing is allocated per call. Patterns
+ * are decoded with the same loader as the program (parse_pattern), into the spare
+ * board first, so a malformed one leaves the current board as it was. Snapshots use
+ * the checkpoint format (see gol_ckpt.c), so one written to a file can be continued
+ * with --resume and the other way around.
+ * Every engine hands its own rule to the kernels, so engines with different rules can
+ * be stepped on different threads at once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_lib.h"
+#include "gol_board.h"
+#include "gol_io.h"
+#include "gol_swar.h"
+#include "gol_simd.h"
+#include "gol_rule.h"
+#include "gol_ckpt.h"
+
+// the handle of gol_lib.h
+struct gol_engine {
+    gol_board boards[2];    // cur and next point at these
+    gol_board* cur;         // the current generation
+    gol_board* next;        // the generation being written, and where patterns are decoded
+    uint64_t* cells;        // one buffer holding the cells of both boards
+    size_t room;            // bytes of that buffer each board may use
+    int wrap;               // 1 wrap, 0 nowrap
+    long generation;        // generations stepped since the board was loaded
+    row_fn kernel;          // row kernel picked for this CPU
+    gol_rule rule;          // rule the engine steps with
+    char message[128];      // what the last failed call ran into
+};
+
+/* lib_error(gol_engine*, int, const char*);
+ * Records why a call failed, for gol_last_error.
+ * @return: code, so a call can return it
+ */
+static int lib_error(gol_engine* e, int code, const char* what) {
+    snprintf(e->message, sizeof(e->message), "%s", what);
+    return code;
+}
+
+/* gol_create(gol_engine**, int, int, int);
+ * Creates an engine holding an empty ROWSxCOLS board. The memory of its two boards is
+ * taken here, once; later patterns and snapshots must fit in it (any board that takes
+ * no more memory than ROWSxCOLS, see gol_board.h).
+ * @param pe: where the engine is stored, NULL on failure
+ * @param rows: number of rows of the largest board
+ * @param cols: number of cols of the largest board
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ * @return: GOL_OK, GOL_ERR_ARG or GOL_ERR_NOMEM
+ */
+int gol_create(gol_engine** pe, int rows, int cols, int wrap) {
+    if (pe == NULL) {
+        return GOL_ERR_ARG;
+    }
+    *pe = NULL;
+    if (rows < 1 || cols < 1 || rows > GOL_MAX_SIDE || cols > GOL_MAX_SIDE || (wrap != 0 && wrap != 1)) {
+        return GOL_ERR_ARG;
+    }
+    gol_engine* e = malloc(sizeof(gol_engine));
+    if (e == NULL) {
+        return GOL_ERR_NOMEM;
+    }
+    e->room = board_layout(&e->boards[0], rows, cols);
+    if (posix_memalign((void**)&e->cells, GOL_ALIGN, 2 * e->room) != 0) {
+        free(e);
+        return GOL_ERR_NOMEM;
+    }
+    memset(e->cells, 0, 2 * e->room);
+    for (int b = 0; b < 2; b++) {
+        board_layout(&e->boards[b], rows, cols);
+        e->boards[b].cells = e->cells + b * (e->room / sizeof(uint64_t));
+        e->boards[b].bytes = e->room;
+        e->boards[b].map = NULL;
+        e->boards[b].mapBytes = 0;
+        e->boards[b].arena = NULL;
+        e->boards[b].hashes = NULL;
+#ifdef GOL_STATS
+        e->boards[b].counts = NULL;
+#endif
+    }
+    e->cur = &e->boards[0];
+    e->next = &e->boards[1];
+    e->wrap = wrap;
+    e->generation = 0;
+    e->kernel = avx512_supported() ? avx512_row : avx2_supported() ? avx2_row : swar_row;
+    parse_rule("B3/S23", &e->rule);
+    e->message[0] = '\0';
+    *pe = e;
+    return GOL_OK;
+}
+
+/* gol_destroy(gol_engine**);
+ * Frees the engine and sets the caller's pointer to NULL. NULL is ignored.
+ * @param pe: pointer to the gol_engine*
+ */
+void gol_destroy(gol_engine** pe) {
+    if (pe == NULL || *pe == NULL) {
+        return;
+    }
+    free((*pe)->cells);
+    free(*pe);
+    *pe = NULL;
+}
+
+/* gol_load(gol_engine*, const char*, size_t);
+ * Replaces the board with a pattern held in memory, in any format a config file can
+ * have (original, RLE or Life 1.06), and starts counting generations from 0 again. An
+ * iteration count in the pattern is ignored; the host steps with gol_step. On failure
+ * the board is left as it was.
+ * @param e: the engine
+ * @param text: the pattern, not necessarily 0 terminated
+ * @param len: its length in bytes
+ * @return: GOL_OK, GOL_ERR_ARG, GOL_ERR_PARSE or GOL_ERR_SIZE
+ */
+int gol_load(gol_engine* e, const char* text, size_t len) {
+    if (e == NULL || text == NULL) {
+        return GOL_ERR_ARG;
+    }
+    int row, col;
+    long iter;
+    gol_load_error err;
+    if (parse_pattern(text, len, e->next, 0, &row, &col, &iter, &err) == NULL) {
+        // the spare board may have been laid out for the pattern before it failed, it
+        // has to match the current board again before the next step
+        reuse_board(e->next, e->cur->row, e->cur->col);
+        snprintf(e->message, sizeof(e->message), "line %d: %s", err.line, err.what);
+        return err.room ? GOL_ERR_SIZE : GOL_ERR_PARSE;
+    }
+    gol_board* temp = e->cur;
+    e->cur = e->next;
+    e->next = temp;
+    // the other board only needs the same layout and a dead last row
+    reuse_board(e->next, row, col);
+    e->generation = 0;
+    return GOL_OK;
+}
+
+/* gol_set_rule(gol_engine*, const char*);
+ * Sets the rule the engine steps with, in B/S notation or by name, as -r takes it.
+ * @param e: the engine
+ * @param text: the rule, "B36/S23" or "highlife"
+ * @return: GOL_OK, GOL_ERR_ARG or GOL_ERR_RULE
+ */
+int gol_set_rule(gol_engine* e, const char* text) {
+    if (e == NULL || text == NULL) {
+        return GOL_ERR_ARG;
+    }
+    gol_rule rule;
+    if (parse_rule(text, &rule) != 0) {
+        return lib_error(e, GOL_ERR_RULE, "rule must be in B/S notation, like B36/S23, or a known name");
+    }
+    e->rule = rule;
+    return GOL_OK;
+}
+
+/* gol_step(gol_engine*, long);
+ * Advances the board n generations.
+ * @param e: the engine
+ * @param n: generations to step, 0 does nothing
+ * @return: GOL_OK or GOL_ERR_ARG
+ */
+int gol_step(gol_engine* e, long n) {
+    if (e == NULL) {
+        return GOL_ERR_ARG;
+    }
+    if (n < 0) {
+        return lib_error(e, GOL_ERR_ARG, "number of generations can not be negative");
+    }
+    int row = e->cur->row;
+    for (long g = 0; g < n; g++) {
+        step_rows(e->kernel, e->cur, e->next, 0, row, e->wrap, &e->rule);
+        gol_board* temp = e->cur;
+        e->cur = e->next;
+        e->next = temp;
+    }
+    e->generation += n;
+    return GOL_OK;
+}
+
+/* gol_size(const gol_engine*, int*, int*);
+ * Stores the size of the current board in *prows and *pcols.
+ * @return: GOL_OK or GOL_ERR_ARG
+ */
+int gol_size(const gol_engine* e, int* prows, int* pcols) {
+    if (e == NULL || prows == NULL || pcols == NULL) {
+        return GOL_ERR_ARG;
+    }
+    *prows = e->cur->row;
+    *pcols = e->cur->col;
+    return GOL_OK;
+}
+
+/* gol_generation(const gol_engine*);
+ * @return: generations stepped since the board was loaded (or the generation of a
+ * restored snapshot), GOL_ERR_ARG for a NULL engine
+ */
+long gol_generation(const gol_engine* e) {
+    return e == NULL ? GOL_ERR_ARG : e->generation;
+}
+
+/* gol_population(const gol_engine*);
+ * @return: number of live cells, GOL_ERR_ARG for a NULL engine
+ */
+long gol_population(const gol_engine* e) {
+    if (e == NULL) {
+        return GOL_ERR_ARG;
+    }
+    // bits past the last column are always 0, so whole words can be counted
+    long population = 0;
+    for (int r = 0; r < e->cur->row; r++) {
+        const uint64_t* cells = board_row(e->cur, r);
+        for (int w = 0; w < e->cur->words; w++) {
+            population += __builtin_popcountll(cells[w]);
+        }
+    }
+    return population;
+}
+
+/* gol_cell(const gol_engine*, int, int);
+ * @return: 1 if the cell at r, c is alive, 0 if it is dead, GOL_ERR_ARG or GOL_ERR_RANGE
+ */
+int gol_cell(const gol_engine* e, int r, int c) {
+    if (e == NULL) {
+        return GOL_ERR_ARG;
+    }
+    if (r < 0 || c < 0 || r >= e->cur->row || c >= e->cur->col) {
+        return GOL_ERR_RANGE;
+    }
+    return get_cell(e->cur, r, c);
+}
+
+/* gol_region(const gol_engine*, int, int, int, int, uint8_t*);
+ * Copies the states of a rectangle of cells into out, one byte per cell (1 alive,
+ * 0 dead), row after row.
+ * @param e: the engine
+ * @param r0: first row of the rectangle
+ * @param c0: first col of the rectangle
+ * @param rows: rows in the rectangle
+ * @param cols: cols in the rectangle
+ * @param out: rows * cols bytes
+ * @return: GOL_OK, GOL_ERR_ARG or GOL_ERR_RANGE
+ */
+int gol_region(const gol_engine* e, int r0, int c0, int rows, int cols, uint8_t* out) {
+    if (e == NULL || out == NULL || rows < 0 || cols < 0) {
+        return GOL_ERR_ARG;
+    }
+    if (r0 < 0 || c0 < 0 || r0 > e->cur->row - rows || c0 > e->cur->col - cols) {
+        return GOL_ERR_RANGE;
+    }
+    for (int r = 0; r < rows; r++) {
+        const uint64_t* cells = board_row(e->cur, r0 + r);
+        uint8_t* line = out + (size_t)r * cols;
+        for (int c = 0; c < cols; c++) {
+            int at = c0 + c;
+            line[c] = (cells[at / GOL_WORD_BITS] >> (at % GOL_WORD_BITS)) & 1;
+        }
+    }
+    return GOL_OK;
+}
+
+/* gol_snapshot_bytes(const gol_engine*);
+ * @return: size of a snapshot of the current board, 0 for a NULL engine
+ */
+size_t gol_snapshot_bytes(const gol_engine* e) {
+    if (e == NULL) {
+        return 0;
+    }
+    return sizeof(ckpt_header) + (size_t)(e->cur->row + 1) * e->cur->stride * sizeof(uint64_t);
+}
+
+/* gol_snapshot(const gol_engine*, void*, size_t);
+ * Writes the board, its generation, topology and rule into buf in the checkpoint
+ * format (see gol_ckpt.h), ready to be kept in memory, sent elsewhere or written to a
+ * file for --resume.
+ * @param e: the engine
+ * @param buf: at least gol_snapshot_bytes bytes
+ * @param size: size of buf
+ * @return: GOL_OK or GOL_ERR_ARG
+ */
+int gol_snapshot(const gol_engine* e, void* buf, size_t size) {
+    if (e == NULL || buf == NULL || size < gol_snapshot_bytes(e)) {
+        return GOL_ERR_ARG;
+    }
+    ckpt_header head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, CKPT_MAGIC, sizeof(head.magic));
+    head.version = CKPT_VERSION;
+    head.wrap = e->wrap;
+    head.row = e->cur->row;
+    head.col = e->cur->col;
+    head.words = e->cur->words;
+    head.stride = e->cur->stride;
+    head.generation = e->generation;
+    // nothing is planned past the current generation, --resume takes -n for that
+    head.total = e->generation;
+    head.born = e->rule.born;
+    head.survive = e->rule.survive;
+    memcpy(buf, &head, sizeof(head));
+    memcpy((char*)buf + sizeof(head), e->cur->cells, gol_snapshot_bytes(e) - sizeof(head));
+    return GOL_OK;
+}
+
+/* gol_restore(gol_engine*, const void*, size_t);
+ * Replaces the board with one from gol_snapshot (or a --checkpoint-every file read into
+ * memory), generation included. The snapshot must have the engine's topology and
+ * rule. On failure the board is left as it was.
+ * @param e: the engine
+ * @param buf: the snapshot
+ * @param size: its length in bytes
+ * @return: GOL_OK, GOL_ERR_ARG, GOL_ERR_SNAPSHOT or GOL_ERR_SIZE
+ */
+int gol_restore(gol_engine* e, const void* buf, size_t size) {
+    if (e == NULL || buf == NULL) {
+        return GOL_ERR_ARG;
+    }
+    ckpt_header head;
+    if (size < sizeof(head)) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, "too short to be a snapshot");
+    }
+    // buf may not be aligned for the header
+    memcpy(&head, buf, sizeof(head));
+    if (memcmp(head.magic, CKPT_MAGIC, sizeof(head.magic)) != 0 || head.version != CKPT_VERSION) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, "not a snapshot of this version");
+    }
+    gol_board shape;
+    if (head.row < 1 || head.col < 1 || head.row > GOL_MAX_SIDE || head.col > GOL_MAX_SIDE) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, "damaged snapshot");
+    }
+    size_t bytes = board_layout(&shape, head.row, head.col);
+    if (head.words != shape.words || head.stride != shape.stride || size != sizeof(head) + bytes ||
+        head.generation < 0) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, "damaged snapshot");
+    }
+    if (head.wrap != e->wrap) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, head.wrap ? "snapshot is of a wrap board" : "snapshot is of a nowrap board");
+    }
+    if (head.born != e->rule.born || head.survive != e->rule.survive) {
+        return lib_error(e, GOL_ERR_SNAPSHOT, "snapshot was stepped with another rule");
+    }
+    if (bytes > e->room) {
+        return lib_error(e, GOL_ERR_SIZE, "snapshot is larger than the room for it");
+    }
+
+    board_layout(e->cur, head.row, head.col);
+    memcpy(e->cur->cells, (const char*)buf + sizeof(head), bytes);
+    // whatever the snapshot says, the bits past the last column and the row past the
+    // last stay dead; the kernels shift padding bits into the cells next to it
+    uint64_t keep = ~(uint64_t)0 >> (GOL_WORD_BITS - 1 - (head.col - 1) % GOL_WORD_BITS);
+    for (int r = 0; r < head.row; r++) {
+        uint64_t* cells = board_row(e->cur, r);
+        cells[e->cur->words - 1] &= keep;
+        memset(cells + e->cur->words, 0, (e->cur->stride - e->cur->words) * sizeof(uint64_t));
+    }
+    memset(board_row(e->cur, head.row), 0, e->cur->stride * sizeof(uint64_t));
+    reuse_board(e->next, head.row, head.col);
+    e->generation = head.generation;
+    return GOL_OK;
+}
+
+/* gol_last_error(const gol_engine*);
+ * @return: description of what the last failed gol_load, gol_set_rule, gol_step or
+ * gol_restore ran into (with the line for a malformed pattern), "" if none has failed
+ */
+const char* gol_last_error(const gol_engine* e) {
+    return e == NULL ? "no engine" : e->message;
+}
+
+/* gol_strerror(int);
+ * @return: short description of a GOL_* code
+ */
+const char* gol_strerror(int code) {
+    // indexed by -code
+    const char* names[] = {"success", "invalid argument", "out of memory", "malformed pattern",
+                           "board larger than the engine's room", "cell outside the board", "invalid rule",
+                           "invalid snapshot"};
+    if (code > 0 || code < GOL_ERR_SNAPSHOT) {
+        return "unknown error";
+    }
+    return names[-code];
+}
@@ -0,0 +1,60 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_lib.h
+ * The library interface (make lib builds libgol.a and libgol.so). A host creates an
+ * engine, loads a pattern into it from memory and steps it as many generations at a
+ * time as it likes, reading cells back in between. Every call returns its error instead
+ * of printing and exiting, and only gol_create and gol_destroy allocate or free, so a
+ * host can drive many engines at a high rate. This header is all a host needs.
+ */
+#ifndef GOL_LIB_H
+#define GOL_LIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// what every call returns, 0 or one of the negative codes below
+#define GOL_OK 0
+#define GOL_ERR_ARG -1          // NULL handle or buffer, negative count, bad size
+#define GOL_ERR_NOMEM -2        // gol_create could not get the memory for its boards
+#define GOL_ERR_PARSE -3        // malformed pattern, gol_last_error gives the line
+#define GOL_ERR_SIZE -4         // pattern or snapshot larger than the room gol_create reserved
+#define GOL_ERR_RANGE -5        // cell or region outside the board
+#define GOL_ERR_RULE -6         // rule not in B/S notation or one of the known names
+#define GOL_ERR_SNAPSHOT -7     // not a snapshot, damaged, or saved with another topology or rule
+
+// the library is built with -fvisibility=hidden, only the calls below are exported
+// from libgol.so (and left global in libgol.a), so its internals can not clash with
+// the host's own symbols
+#if defined(__GNUC__)
+#define GOL_API __attribute__((visibility("default")))
+#else
+#define GOL_API
+#endif
+
+// one board being stepped, only used through the calls below
+typedef struct gol_engine gol_engine;
+
+GOL_API int gol_create(gol_engine**, int, int, int);
+GOL_API void gol_destroy(gol_engine**);
+GOL_API int gol_load(gol_engine*, const char*, size_t);
+GOL_API int gol_set_rule(gol_engine*, const char*);
+GOL_API int gol_step(gol_engine*, long);
+GOL_API int gol_size(const gol_engine*, int*, int*);
+GOL_API long gol_generation(const gol_engine*);
+GOL_API long gol_population(const gol_engine*);
+GOL_API int gol_cell(const gol_engine*, int, int);
+GOL_API int gol_region(const gol_engine*, int, int, int, int, uint8_t*);
+GOL_API size_t gol_snapshot_bytes(const gol_engine*);
+GOL_API int gol_snapshot(const gol_engine*, void*, size_t);
+GOL_API int gol_restore(gol_engine*, const void*, size_t);
+GOL_API const char* gol_last_error(const gol_engine*);
+GOL_API const char* gol_strerror(int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,356 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_libtest.c
+ * Host side checks of the library (gol_lib.h), run by make test. Each check drives
+ * engines the way an embedding program would and compares what they hold with an
+ * engine that took the straight path. Prints one line per failed check and exits with
+ * 1 if there was any. Given a pattern file, it instead steps it the long way round (many
+ * calls, a snapshot restored into another engine) and prints the board, which
+ * gol_test.sh compares with what print gives for the same run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "gol_lib.h"
+
+// a glider in the corner of a 1000x1000 board, in the original format
+static const char glider[] = "1000 1000 0\n0 1\n1 2\n2 0\n2 1\n2 2\n";
+
+// soup of rules_on_threads, stepped long enough for the rules to part
+#define SOUP_SIZE 256
+#define SOUP_GENERATIONS 2000
+// room of the engine that steps a pattern file, the bundled ones are far smaller
+#define FILE_ROOM 1024
+
+static int failures = 0;
+
+/* check(int, const char*);
+ * Reports a failed check.
+ */
+static void check(int ok, const char* what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/* same_board(const gol_engine*, const gol_engine*);
+ * @return: 1 if both engines hold the same size board with the same cells
+ */
+static int same_board(const gol_engine* a, const gol_engine* b) {
+    int ra, ca, rb, cb;
+    if (gol_size(a, &ra, &ca) != GOL_OK || gol_size(b, &rb, &cb) != GOL_OK || ra != rb || ca != cb) {
+        return 0;
+    }
+    for (int r = 0; r < ra; r++) {
+        for (int c = 0; c < ca; c++) {
+            if (gol_cell(a, r, c) != gol_cell(b, r, c)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* failed_load();
+ * A pattern that fails part way, after its header asked for a far wider board, must
+ * leave the engine stepping the board it had.
+ */
+static void failed_load(void) {
+    gol_engine* e;
+    gol_engine* ref;
+    check(gol_create(&e, 1000, 1000, 1) == GOL_OK && gol_create(&ref, 1000, 1000, 1) == GOL_OK, "create");
+    check(gol_load(e, glider, strlen(glider)) == GOL_OK, "load the glider");
+    check(gol_load(ref, glider, strlen(glider)) == GOL_OK, "load the glider again");
+
+    const char* bad[] = {"10 64000 0\n1 1\nzz\n", "x = 64000, y = 10\n3o$%!\n", "5 5 0\n9 9\n",
+                         "x = 64000, y = 10\n64001b!\n", "x = 64000, y = 10\n11$!\n"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        check(gol_load(e, bad[i], strlen(bad[i])) == GOL_ERR_PARSE, "malformed pattern is refused");
+        check(gol_step(e, 1) == GOL_OK && gol_step(ref, 1) == GOL_OK, "step after a failed load");
+        check(same_board(e, ref), "failed load left the board as it was");
+    }
+    gol_destroy(&e);
+    gol_destroy(&ref);
+}
+
+/* soup(char*, size_t);
+ * Writes a random looking SOUP_SIZE square board, the same every run, in the original
+ * format.
+ * @return: length of the pattern
+ */
+static size_t soup(char* buf, size_t bytes) {
+    size_t n = snprintf(buf, bytes, "%d %d 0\n", SOUP_SIZE, SOUP_SIZE);
+    uint32_t x = 12345;
+    for (int r = 0; r < SOUP_SIZE; r++) {
+        for (int c = 0; c < SOUP_SIZE; c++) {
+            x = x * 1103515245 + 12345;
+            if ((x >> 16) % 3 == 0) {
+                n += snprintf(buf + n, bytes - n, "%d %d\n", r, c);
+            }
+        }
+    }
+    return n;
+}
+
+/* step_one_at_a_time(void*);
+ * Thread body of rules_on_threads, steps its engine one generation per call so the
+ * calls of both threads interleave.
+ * @param arg: the engine
+ */
+static void* step_one_at_a_time(void* arg) {
+    for (int g = 0; g < SOUP_GENERATIONS; g++) {
+        gol_step(arg, 1);
+    }
+    return NULL;
+}
+
+/* rules_on_threads();
+ * Two engines with different rules stepped on two threads at once must end up where
+ * they do when stepped one after the other.
+ */
+static void rules_on_threads(void) {
+    static char buf[SOUP_SIZE * SOUP_SIZE * 10];
+    size_t n = soup(buf, sizeof(buf));
+    const char* rules[2] = {"B3/S23", "highlife"};
+    gol_engine* e[2];
+    gol_engine* ref[2];
+    for (int i = 0; i < 2; i++) {
+        check(gol_create(&e[i], SOUP_SIZE, SOUP_SIZE, 1) == GOL_OK &&
+              gol_create(&ref[i], SOUP_SIZE, SOUP_SIZE, 1) == GOL_OK, "create");
+        check(gol_load(e[i], buf, n) == GOL_OK && gol_load(ref[i], buf, n) == GOL_OK, "load the soup");
+        check(gol_set_rule(e[i], rules[i]) == GOL_OK && gol_set_rule(ref[i], rules[i]) == GOL_OK, "set the rule");
+        check(gol_step(ref[i], SOUP_GENERATIONS) == GOL_OK, "step on one thread");
+    }
+    check(!same_board(ref[0], ref[1]), "the two rules give different boards");
+
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        check(pthread_create(&threads[i], NULL, step_one_at_a_time, e[i]) == 0, "start a thread");
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+        check(same_board(e[i], ref[i]), "engines stepped at once keep their own rule");
+        gol_destroy(&e[i]);
+        gol_destroy(&ref[i]);
+    }
+}
+
+/* step_by_n();
+ * Stepping a board N generations in one call must give the board of N calls of one
+ * generation, and of calls of mixed lengths, for wrap and nowrap.
+ */
+static void step_by_n(void) {
+    static char buf[SOUP_SIZE * SOUP_SIZE * 10];
+    size_t n = soup(buf, sizeof(buf));
+    for (int wrap = 0; wrap <= 1; wrap++) {
+        gol_engine* e[3];
+        for (int i = 0; i < 3; i++) {
+            check(gol_create(&e[i], SOUP_SIZE, SOUP_SIZE, wrap) == GOL_OK, "create");
+            check(gol_load(e[i], buf, n) == GOL_OK, "load the soup");
+        }
+        check(gol_step(e[0], 500) == GOL_OK, "step 500 at once");
+        for (int g = 0; g < 500; g++) {
+            gol_step(e[1], 1);
+        }
+        for (long g = 0, k = 1; g < 500; g += k, k++) {
+            gol_step(e[2], (g + k > 500) ? 500 - g : k);
+        }
+        for (int i = 1; i < 3; i++) {
+            check(gol_generation(e[i]) == 500, "generation counts every step");
+            check(same_board(e[0], e[i]), "one call of N gives the board of many shorter ones");
+        }
+        for (int i = 0; i < 3; i++) {
+            gol_destroy(&e[i]);
+        }
+    }
+}
+
+/* snapshot_round_trip();
+ * A snapshot restored into the engine it came from, or into another one, must carry on
+ * to the board the engine would have reached without it.
+ */
+static void snapshot_round_trip(void) {
+    static char buf[SOUP_SIZE * SOUP_SIZE * 10];
+    size_t n = soup(buf, sizeof(buf));
+    gol_engine* e;
+    gol_engine* other;
+    gol_engine* ref;
+    check(gol_create(&e, SOUP_SIZE, SOUP_SIZE, 1) == GOL_OK && gol_create(&other, SOUP_SIZE, SOUP_SIZE, 1) == GOL_OK &&
+          gol_create(&ref, SOUP_SIZE, SOUP_SIZE, 1) == GOL_OK, "create");
+    check(gol_load(e, buf, n) == GOL_OK && gol_load(ref, buf, n) == GOL_OK, "load the soup");
+    check(gol_step(e, 100) == GOL_OK && gol_step(ref, 300) == GOL_OK, "step");
+
+    size_t bytes = gol_snapshot_bytes(e);
+    void* snap = malloc(bytes);
+    check(snap != NULL && gol_snapshot(e, snap, bytes) == GOL_OK, "take a snapshot");
+    check(gol_snapshot(e, snap, bytes - 1) == GOL_ERR_ARG, "snapshot into a short buffer is refused");
+    check(gol_step(e, 50) == GOL_OK, "step past the snapshot");
+    check(gol_restore(e, snap, bytes) == GOL_OK && gol_generation(e) == 100, "restore into the same engine");
+    check(gol_restore(other, snap, bytes) == GOL_OK && gol_generation(other) == 100, "restore into another engine");
+    check(gol_restore(other, snap, bytes - 1) == GOL_ERR_SNAPSHOT, "cut short snapshot is refused");
+    check(gol_step(e, 200) == GOL_OK && gol_step(other, 200) == GOL_OK, "step after a restore");
+    check(same_board(e, ref) && same_board(other, ref), "restored engines reach the board of the one never restored");
+    free(snap);
+    gol_destroy(&e);
+    gol_destroy(&other);
+    gol_destroy(&ref);
+}
+
+/* region_reads();
+ * Rectangles read with gol_region, at every offset within a word and across word
+ * boundaries, must hold what gol_cell gives cell by cell.
+ */
+static void region_reads(void) {
+    static char buf[SOUP_SIZE * SOUP_SIZE * 10];
+    static uint8_t out[SOUP_SIZE * SOUP_SIZE];
+    size_t n = soup(buf, sizeof(buf));
+    gol_engine* e;
+    check(gol_create(&e, SOUP_SIZE, SOUP_SIZE, 0) == GOL_OK, "create");
+    check(gol_load(e, buf, n) == GOL_OK && gol_step(e, 37) == GOL_OK, "load and step the soup");
+
+    int bad = 0;
+    for (int r0 = 0; r0 < 5; r0++) {
+        for (int c0 = 0; c0 < 70; c0++) {
+            int rows = SOUP_SIZE - 3 * r0, cols = SOUP_SIZE - 2 * c0 - 1;
+            if (gol_region(e, r0, c0, rows, cols, out) != GOL_OK) {
+                bad = 1;
+                continue;
+            }
+            for (int r = 0; r < rows; r++) {
+                for (int c = 0; c < cols; c++) {
+                    bad |= out[(size_t)r * cols + c] != gol_cell(e, r0 + r, c0 + c);
+                }
+            }
+        }
+    }
+    check(!bad, "region reads match the cells");
+    check(gol_region(e, 1, 0, SOUP_SIZE, 1, out) == GOL_ERR_RANGE, "region past the last row is refused");
+    check(gol_region(e, 0, SOUP_SIZE - 1, 1, 2, out) == GOL_ERR_RANGE, "region past the last col is refused");
+    gol_destroy(&e);
+}
+
+/* restore_padding();
+ * A snapshot with every bit set, padding included, must restore as a full board and
+ * step like one: bits past the last column can not come back as cells.
+ */
+static void restore_padding(void) {
+    // 70 columns, so the last word of a row is mostly padding
+    static char full[20 * 70 * 8 + 32];
+    size_t n = snprintf(full, sizeof(full), "20 70 0\n");
+    for (int r = 0; r < 20; r++) {
+        for (int c = 0; c < 70; c++) {
+            n += snprintf(full + n, sizeof(full) - n, "%d %d\n", r, c);
+        }
+    }
+    const char one[] = "20 70 0\n0 0\n";
+    const char none[] = "20 70 0\n";
+    for (int wrap = 0; wrap <= 1; wrap++) {
+        gol_engine* e;
+        gol_engine* ref;
+        check(gol_create(&e, 20, 70, wrap) == GOL_OK && gol_create(&ref, 20, 70, wrap) == GOL_OK, "create");
+        size_t bytes = gol_snapshot_bytes(e);
+        uint8_t* snap = malloc(bytes);
+        uint8_t* empty = malloc(bytes);
+        check(snap != NULL && empty != NULL, "room for the snapshots");
+        // the first byte a single cell changes is where the cells start
+        check(gol_load(e, one, strlen(one)) == GOL_OK && gol_snapshot(e, snap, bytes) == GOL_OK, "snapshot one cell");
+        check(gol_load(e, none, strlen(none)) == GOL_OK && gol_snapshot(e, empty, bytes) == GOL_OK, "snapshot no cells");
+        size_t start = 0;
+        while (start < bytes && snap[start] == empty[start]) {
+            start++;
+        }
+        check(start < bytes, "a cell shows in the snapshot");
+        memset(empty + start, 0xff, bytes - start);
+        check(gol_restore(e, empty, bytes) == GOL_OK, "restore a snapshot with padding set");
+        check(gol_population(e) == 20 * 70, "padding bits are not counted as cells");
+        check(gol_load(ref, full, n) == GOL_OK, "load a full board");
+        check(gol_step(e, 3) == GOL_OK && gol_step(ref, 3) == GOL_OK && same_board(e, ref),
+              "padding bits do not step into the board");
+        free(snap);
+        free(empty);
+        gol_destroy(&e);
+        gol_destroy(&ref);
+    }
+}
+
+/* run_file(const char*, const char*, const char*);
+ * Steps a pattern file as a host would, in calls of growing length, moving to another
+ * engine through a snapshot half way, and prints the board in the format of print
+ * (one line per row, @ alive, - dead) from one region read.
+ * @param path: the pattern file
+ * @param topology: "wrap" or "nowrap"
+ * @param count: generations to step
+ * @return: 0, or 1 if the file could not be run
+ */
+static int run_file(const char* path, const char* topology, const char* count) {
+    int wrap = strcmp(topology, "wrap") == 0;
+    char* end;
+    long total = strtol(count, &end, 10);
+    FILE* f = fopen(path, "rb");
+    if (f == NULL || *end != '\0' || total < 0 || (!wrap && strcmp(topology, "nowrap") != 0)) {
+        printf("error: usage gol_libtest [FILE wrap|nowrap GENERATIONS]\n");
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+    char* text = malloc(len + 1);
+    if (text == NULL || fread(text, 1, len, f) != (size_t)len) {
+        printf("error: can not read %s\n", path);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    gol_engine* e[2];
+    int rows, cols;
+    if (gol_create(&e[0], FILE_ROOM, FILE_ROOM, wrap) != GOL_OK || gol_create(&e[1], FILE_ROOM, FILE_ROOM, wrap) != GOL_OK ||
+        gol_load(e[0], text, len) != GOL_OK) {
+        printf("error: %s: %s\n", path, gol_last_error(e[0]));
+        return 1;
+    }
+    free(text);
+    int at = 0;
+    for (long g = 0, k = 1; g < total; g += k, k++) {
+        if (at == 0 && g >= total / 2) {
+            size_t bytes = gol_snapshot_bytes(e[0]);
+            void* snap = malloc(bytes);
+            check(snap != NULL && gol_snapshot(e[0], snap, bytes) == GOL_OK && gol_restore(e[1], snap, bytes) == GOL_OK,
+                  "move to another engine through a snapshot");
+            free(snap);
+            at = 1;
+        }
+        check(gol_step(e[at], (g + k > total) ? total - g : k) == GOL_OK, "step");
+    }
+    check(gol_generation(e[at]) == total, "generation counts every step");
+
+    gol_size(e[at], &rows, &cols);
+    uint8_t* cells = malloc((size_t)rows * cols);
+    check(cells != NULL && gol_region(e[at], 0, 0, rows, cols, cells) == GOL_OK, "read the board");
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            putchar(cells[(size_t)r * cols + c] ? '@' : '-');
+        }
+        putchar('\n');
+    }
+    free(cells);
+    gol_destroy(&e[0]);
+    gol_destroy(&e[1]);
+    return failures > 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4) {
+        return run_file(argv[1], argv[2], argv[3]);
+    }
+    failed_load();
+    rules_on_threads();
+    step_by_n();
+    snapshot_round_trip();
+    region_reads();
+    restore_padding();
+    if (failures == 0) {
+        printf("libtest: every library check passed\n");
+    }
+    return failures > 0;
+}
@@ -0,0 +1,107 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_pool.c
+ * This file runs a generation on several cores. The board is split into horizontal bands,
+ * one per thread, and every band is stepped with the same row kernel the single threaded
+ * engines use. The threads are started once and wait on a barrier between generations,
+ * so a generation costs two barrier waits rather than creating threads. The calling
+ * thread steps band 0 itself, then swaps the boards with swap_board as before.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "gol_pool.h"
+
+/* pool_worker(void*);
+ * Body of every worker thread. Waits for a generation, steps its band, waits for the
+ * other bands, and repeats until the pool is freed.
+ * @param arg: the gol_band this thread owns
+ */
+static void* pool_worker(void* arg) {
+    gol_band* band = arg;
+    gol_pool* pool = band->pool;
+
+    while (1) {
+        // wait for the boards of the next generation (or for quit)
+        pthread_barrier_wait(&pool->start);
+        if (pool->quit) {
+            break;
+        }
+        step_rows(pool->kernel, pool->old, pool->new, band->r0, band->r1, pool->wrap, &golRule);
+        pthread_barrier_wait(&pool->done);
+    }
+    return NULL;
+}
+
+/* create_pool(int, int, row_fn, int);
+ * Create pool splits row rows into even bands and starts a worker for every band but
+ * the first. There are never more bands than rows.
+ * @param threads: number of threads to step with, including the caller
+ * @param row: number of rows on the board
+ * @param kernel: row kernel to step every band with
+ * @param wrap: 1 wrap, 0 nowrap
+ * @return: the running pool
+ */
+gol_pool* create_pool(int threads, int row, row_fn kernel, int wrap) {
+    gol_pool* pool = malloc(sizeof(gol_pool));
+    if (pool == NULL) {
+        printf("error: unable to allocate a pool of %d threads\n", threads);
+        exit(-1);
+    }
+    pool->threads = (threads < row) ? threads : row;
+    pool->ids = malloc(pool->threads * sizeof(pthread_t));
+    pool->bands = malloc(pool->threads * sizeof(gol_band));
+    if (pool->ids == NULL || pool->bands == NULL) {
+        printf("error: unable to allocate a pool of %d threads\n", pool->threads);
+        exit(-1);
+    }
+    pool->kernel = kernel;
+    pool->wrap = wrap;
+    pool->quit = 0;
+    pthread_barrier_init(&pool->start, NULL, pool->threads);
+    pthread_barrier_init(&pool->done, NULL, pool->threads);
+
+    for (int i = 0; i < pool->threads; i++) {
+        // band i gets rows [i*row/threads, (i+1)*row/threads)
+        pool->bands[i].pool = pool;
+        pool->bands[i].r0 = (int)((long)i * row / pool->threads);
+        pool->bands[i].r1 = (int)((long)(i + 1) * row / pool->threads);
+        if (i > 0 && pthread_create(&pool->ids[i], NULL, pool_worker, &pool->bands[i]) != 0) {
+            printf("error: unable to start thread %d\n", i);
+            exit(-1);
+        }
+    }
+    return pool;
+}
+
+/* pool_step(gol_pool*, const gol_board*, gol_board*);
+ * Steps old into new on every thread of the pool and returns once all bands are done,
+ * so new can be swapped and read right away.
+ * @param pool: running pool
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ */
+void pool_step(gol_pool* pool, const gol_board* old, gol_board* new) {
+    pool->old = old;
+    pool->new = new;
+    pthread_barrier_wait(&pool->start);
+    // the caller runs the first band
+    step_rows(pool->kernel, old, new, pool->bands[0].r0, pool->bands[0].r1, pool->wrap, &golRule);
+    pthread_barrier_wait(&pool->done);
+}
+
+/* free_pool(gol_pool**);
+ * Tells the workers to exit, waits for them and frees the pool.
+ * @param ppool: pointer to the pool, set to NULL
+ */
+void free_pool(gol_pool** ppool) {
+    gol_pool* pool = *ppool;
+    pool->quit = 1;
+    pthread_barrier_wait(&pool->start);
+    for (int i = 1; i < pool->threads; i++) {
+        pthread_join(pool->ids[i], NULL);
+    }
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->done);
+    free(pool->ids);
+    free(pool->bands);
+    free(pool);
+    *ppool = NULL;
+}
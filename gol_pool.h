@@ -0,0 +1,35 @@
+#ifndef GOL_POOL_H
+#define GOL_POOL_H
+
+#include <pthread.h>
+#include "gol_board.h"
+#include "gol_swar.h"
+
+struct gol_pool;
+
+// what one worker needs to find its band
+typedef struct gol_band {
+    struct gol_pool* pool;  // pool the worker belongs to
+    int r0;                 // first row of the band
+    int r1;                 // one past the last row of the band
+} gol_band;
+
+// persistent workers stepping horizontal bands of the board
+typedef struct gol_pool {
+    int threads;                // number of bands, the calling thread runs band 0
+    pthread_t* ids;             // worker threads (threads - 1 of them)
+    gol_band* bands;            // one band per thread
+    pthread_barrier_t start;    // released when a generation is ready to step
+    pthread_barrier_t done;     // released when every band has been stepped
+    row_fn kernel;              // row kernel every band runs
+    int wrap;                   // 1 wrap, 0 nowrap
+    const gol_board* old;       // board being read this generation
+    gol_board* new;             // board being written this generation
+    int quit;                   // set to tell the workers to exit
+} gol_pool;
+
+gol_pool* create_pool(int, int, row_fn, int);
+void pool_step(gol_pool*, const gol_board*, gol_board*);
+void free_pool(gol_pool**);
+
+#endif
@@ -0,0 +1,242 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_render.c
+ * This file draws the frames shown with the show option. A frame is built in one buffer
+ * that is reused for the whole run and goes to the terminal in a single write. Only the
+ * lines that differ from the last frame are sent (each one after a cursor move), so a
+ * board that barely changes costs almost nothing to show. The screen is cleared with
+ * ANSI escape codes instead of starting the clear program.
+ * A board that fits the terminal is drawn one character per cell with the same '@' and
+ * '-' as print_board. A taller board uses half block glyphs (two rows per line), and a
+ * board too wide for the terminal uses braille glyphs, 2x4 dots per character, where
+ * every dot stands for a square of cells and is on if any cell in it is alive.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "gol_render.h"
+
+// braille dot bits, [dot row][dot column]
+static const unsigned char brailleBit[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+/* write_out(const char*, size_t);
+ * Writes bytes straight to stdout, after anything printf still has buffered.
+ */
+static void write_out(const char* data, size_t bytes) {
+    fflush(stdout);
+    while (bytes > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, bytes);
+        if (n < 0) {
+            return;
+        }
+        data += n;
+        bytes -= n;
+    }
+}
+
+/* any_bits(const uint64_t*, int, int);
+ * @return: 1 if any of the n bits of row starting at bit c is set
+ */
+static int any_bits(const uint64_t* row, int c, int n) {
+    while (n > 0) {
+        int bit = c % GOL_WORD_BITS;
+        int take = GOL_WORD_BITS - bit < n ? GOL_WORD_BITS - bit : n;
+        uint64_t bits = take == GOL_WORD_BITS ? ~0ULL : ((1ULL << take) - 1) << bit;
+        if (row[c / GOL_WORD_BITS] & bits) {
+            return 1;
+        }
+        c += take;
+        n -= take;
+    }
+    return 0;
+}
+
+/* put_glyph(char*, unsigned);
+ * Stores the UTF-8 encoding of a character from U+0800 to U+FFFF.
+ * @return: number of bytes stored (3)
+ */
+static int put_glyph(char* out, unsigned code) {
+    out[0] = 0xE0 | (code >> 12);
+    out[1] = 0x80 | ((code >> 6) & 0x3F);
+    out[2] = 0x80 | (code & 0x3F);
+    return 3;
+}
+
+/* build_line(gol_render*, const gol_board*, int);
+ * Draws glyph row g of the board into r->line.
+ * @return: number of bytes in the line
+ */
+static int build_line(gol_render* r, const gol_board* board, int g) {
+    char* out = r->line;
+    int len = 0;
+
+    if (r->mode == RENDER_ASCII) {
+        const uint64_t* cells = board_row(board, g);
+        for (int c = 0; c < board->col; c++) {
+            out[len++] = (cells[c / GOL_WORD_BITS] >> (c % GOL_WORD_BITS)) & 1 ? '@' : '-';
+        }
+    }
+    else if (r->mode == RENDER_HALF) {
+        // the bottom half of the last line may be the dead row
+        const uint64_t* top = board_row(board, 2 * g);
+        const uint64_t* bottom = board_row(board, 2 * g + 1);
+        for (int c = 0; c < board->col; c++) {
+            int t = (top[c / GOL_WORD_BITS] >> (c % GOL_WORD_BITS)) & 1;
+            int b = (bottom[c / GOL_WORD_BITS] >> (c % GOL_WORD_BITS)) & 1;
+            if (t == 0 && b == 0) {
+                out[len++] = ' ';
+            }
+            else {
+                // upper half, lower half or full block
+                len += put_glyph(out + len, b == 0 ? 0x2580 : (t == 0 ? 0x2584 : 0x2588));
+            }
+        }
+    }
+    else {
+        // OR together the rows behind each of the 4 dot rows of this line
+        int s = r->scale, words = board->words;
+        for (int k = 0; k < 4; k++) {
+            uint64_t* dots = r->dots + (size_t)k * words;
+            memset(dots, 0, words * sizeof(uint64_t));
+            for (int y = (4 * g + k) * s; y < (4 * g + k + 1) * s && y < board->row; y++) {
+                const uint64_t* cells = board_row(board, y);
+                for (int w = 0; w < words; w++) {
+                    dots[w] |= cells[w];
+                }
+            }
+        }
+        for (int j = 0; j < r->glyphs; j++) {
+            unsigned v = 0;
+            for (int x = 0; x < 2; x++) {
+                int c = (2 * j + x) * s;
+                int n = board->col - c < s ? board->col - c : s;
+                for (int k = 0; n > 0 && k < 4; k++) {
+                    if (any_bits(r->dots + (size_t)k * words, c, n)) {
+                        v |= brailleBit[k][x];
+                    }
+                }
+            }
+            len += put_glyph(out + len, 0x2800 + v);
+        }
+    }
+    return len;
+}
+
+/* create_render(const gol_board*);
+ * Create render picks how the board is drawn from the size of the terminal on stdout
+ * (one line is kept for a status line), and allocates every buffer a frame needs.
+ * When stdout is not a terminal the board is always drawn one character per cell.
+ * @param board: the board that will be shown (only its size is used)
+ * @return: the renderer
+ */
+gol_render* create_render(const gol_board* board) {
+    gol_render* r = calloc(1, sizeof(gol_render));
+    int width = 0, height = 0;
+    struct winsize ws;
+    if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 1) {
+        width = ws.ws_col;
+        height = ws.ws_row - 1;
+    }
+
+    int row = board->row, col = board->col;
+    r->scale = 1;
+    if (width == 0 || (col <= width && row <= height)) {
+        r->mode = RENDER_ASCII;
+        r->lines = row;
+        r->glyphs = col;
+        r->lineMax = col;
+    }
+    else if (col <= width && (row + 1) / 2 <= height) {
+        r->mode = RENDER_HALF;
+        r->lines = (row + 1) / 2;
+        r->glyphs = col;
+        r->lineMax = 3 * col;
+    }
+    else {
+        // smallest square of cells per dot that fits the terminal
+        int s = 1;
+        while ((col + 2 * s - 1) / (2 * s) > width || (row + 4 * s - 1) / (4 * s) > height) {
+            s++;
+        }
+        r->mode = RENDER_BRAILLE;
+        r->scale = s;
+        r->lines = (row + 4 * s - 1) / (4 * s);
+        r->glyphs = (col + 2 * s - 1) / (2 * s);
+        r->lineMax = 3 * r->glyphs;
+        r->dots = malloc(4 * board->words * sizeof(uint64_t));
+    }
+
+    r->prev = malloc((size_t)r->lines * r->lineMax);
+    r->prevLen = malloc(r->lines * sizeof(int));
+    for (int g = 0; g < r->lines; g++) {
+        r->prevLen[g] = -1;
+    }
+    r->line = malloc(r->lineMax + 1);
+    // every line with its cursor move and clear to end of line, the status line, the clear
+    r->cap = (size_t)r->lines * (r->lineMax + 24) + 512;
+    r->frame = malloc(r->cap);
+    if (r->prev == NULL || r->frame == NULL) {
+        printf("error: unable to allocate frame buffers for a %dx%d board\n", row, col);
+        exit(-1);
+    }
+    r->first = 1;
+    return r;
+}
+
+/* render_frame(gol_render*, const gol_board*, const char*);
+ * Draws the board, sending only the lines that changed since the last frame, followed
+ * by a status line. The whole frame goes out in one write.
+ * @param r: the renderer
+ * @param board: board to show
+ * @param status: text for the line under the board
+ */
+void render_frame(gol_render* r, const gol_board* board, const char* status) {
+    char* out = r->frame;
+    size_t n = 0;
+    if (r->first) {
+        n += sprintf(out + n, "\x1b[H\x1b[2J");
+        r->first = 0;
+    }
+    for (int g = 0; g < r->lines; g++) {
+        int len = build_line(r, board, g);
+        char* old = r->prev + (size_t)g * r->lineMax;
+        if (len == r->prevLen[g] && memcmp(old, r->line, len) == 0) {
+            continue;
+        }
+        memcpy(old, r->line, len);
+        r->prevLen[g] = len;
+        // move to the line, draw it and clear anything left from before
+        n += sprintf(out + n, "\x1b[%d;1H", g + 1);
+        memcpy(out + n, r->line, len);
+        n += len;
+        n += sprintf(out + n, "\x1b[K");
+    }
+    n += snprintf(out + n, r->cap - n, "\x1b[%d;1H%.200s\x1b[K", r->lines + 1, status);
+    write_out(out, n);
+}
+
+/* render_clear();
+ * Clears the terminal and moves the cursor to the top left. Does nothing when stdout
+ * is not a terminal, so redirected output only holds the boards.
+ */
+void render_clear(void) {
+    static const char clear[] = "\x1b[H\x1b[2J\x1b[3J";
+    if (isatty(STDOUT_FILENO)) {
+        write_out(clear, sizeof(clear) - 1);
+    }
+}
+
+/* free_render(gol_render**);
+ * Frees the renderer and sets the caller's pointer to NULL.
+ * @param pr: pointer to the gol_render*
+ */
+void free_render(gol_render** pr) {
+    gol_render* r = *pr;
+    free(r->prev);
+    free(r->prevLen);
+    free(r->line);
+    free(r->dots);
+    free(r->frame);
+    free(r);
+    *pr = NULL;
+}
@@ -0,0 +1,33 @@
+#ifndef GOL_RENDER_H
+#define GOL_RENDER_H
+
+#include "gol_board.h"
+
+// how cells are drawn: one character per cell, two cells per half block glyph,
+// or 2x4 blocks of (scale x scale) cells per braille glyph
+#define RENDER_ASCII 0
+#define RENDER_HALF 1
+#define RENDER_BRAILLE 2
+
+// frames of one board size drawn into a reusable buffer
+typedef struct gol_render {
+    int mode;           // RENDER_*
+    int scale;          // board cells per braille dot (on a side), 1 otherwise
+    int lines;          // glyph rows in a frame
+    int glyphs;         // glyphs across a line
+    int lineMax;        // bytes one line can take
+    char* prev;         // last frame, lines of lineMax bytes
+    int* prevLen;       // bytes used in each line of prev, -1 = never drawn
+    char* line;         // line being built
+    uint64_t* dots;     // OR of the board rows behind one row of braille dots
+    char* frame;        // bytes written for one frame
+    size_t cap;         // size of frame
+    int first;          // 1 until the screen has been cleared once
+} gol_render;
+
+gol_render* create_render(const gol_board*);
+void render_frame(gol_render*, const gol_board*, const char*);
+void render_clear(void);
+void free_render(gol_render**);
+
+#endif
@@ -0,0 +1,122 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_rule.c
+ * This file holds the rule the board is stepped with. Any outer totalistic rule can be
+ * given in B/S notation (B36/S23 is HighLife, B3678/S34678 Day & Night, B2/S Seeds), and
+ * it is compiled once into two 9 bit masks and an 18 bit table indexed by the cell and
+ * its neighbour count, so applying it never branches. The kernels check once per row
+ * whether the rule is B3/S23 and keep their hand written Conway logic for it; any other
+ * rule goes through the masks (see rule_word in gol_swar.c).
+ */
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include "gol_rule.h"
+
+// B3/S23 until set_rule says otherwise
+gol_rule golRule = {1 << 3, (1 << 2) | (1 << 3), (1 << 3) | (((1 << 2) | (1 << 3)) << 9), 1, "B3/S23"};
+
+// well known rules that can be given by name
+static const struct {
+    const char* name;
+    const char* rule;
+} namedRules[] = {
+    {"conway", "B3/S23"},
+    {"life", "B3/S23"},
+    {"highlife", "B36/S23"},
+    {"daynight", "B3678/S34678"},
+    {"seeds", "B2/S"},
+    {"lifewithoutdeath", "B3/S012345678"},
+    {"replicator", "B1357/S1357"},
+    {"2x2", "B36/S125"},
+    {"maze", "B3/S12345"},
+};
+
+/* read_counts(const char**, uint16_t*);
+ * Reads neighbour counts (digits 0 to 8) into a mask until the next '/' or the end.
+ * @return: 0 if every character was a count, -1 otherwise
+ */
+static int read_counts(const char** p, uint16_t* mask) {
+    while (**p != '\0' && **p != '/') {
+        if (**p < '0' || **p > '8') {
+            return -1;
+        }
+        *mask |= 1 << (**p - '0');
+        (*p)++;
+    }
+    return 0;
+}
+
+/* parse_rule(const char*, gol_rule*);
+ * Parse rule reads a rule in B/S notation ("B36/S23", either half first, any case) or
+ * one of the names above, and compiles it.
+ * @param text: the rule from the command line
+ * @param rule: where the compiled rule is stored
+ * @return: 0 if the rule was valid, -1 otherwise
+ */
+int parse_rule(const char* text, gol_rule* rule) {
+    for (size_t i = 0; i < sizeof(namedRules) / sizeof(namedRules[0]); i++) {
+        if (strcasecmp(text, namedRules[i].name) == 0) {
+            text = namedRules[i].rule;
+            break;
+        }
+    }
+    uint16_t born = 0, survive = 0;
+    int seenB = 0, seenS = 0;
+    const char* p = text;
+    while (*p != '\0') {
+        char half = toupper((unsigned char)*p++);
+        if (half == 'B' && !seenB) {
+            seenB = 1;
+            if (read_counts(&p, &born) != 0) {
+                return -1;
+            }
+        }
+        else if (half == 'S' && !seenS) {
+            seenS = 1;
+            if (read_counts(&p, &survive) != 0) {
+                return -1;
+            }
+        }
+        else {
+            return -1;
+        }
+        // the halves are split by one '/'
+        if (*p == '/' && p[1] != '\0') {
+            p++;
+        }
+        else if (*p != '\0') {
+            return -1;
+        }
+    }
+    if (!seenB || !seenS) {
+        return -1;
+    }
+
+    rule->born = born;
+    rule->survive = survive;
+    rule->table = born | ((uint32_t)survive << 9);
+    rule->conway = (born == (1 << 3) && survive == ((1 << 2) | (1 << 3)));
+    // written back in the usual order, B then S
+    int n = sprintf(rule->name, "B");
+    for (int k = 0; k <= 8; k++) {
+        if (born & (1 << k)) {
+            rule->name[n++] = '0' + k;
+        }
+    }
+    n += sprintf(rule->name + n, "/S");
+    for (int k = 0; k <= 8; k++) {
+        if (survive & (1 << k)) {
+            rule->name[n++] = '0' + k;
+        }
+    }
+    rule->name[n] = '\0';
+    return 0;
+}
+
+/* set_rule(const gol_rule*);
+ * Makes rule the one the program steps with. Called once, before any board is stepped.
+ * @param rule: a rule from parse_rule
+ */
+void set_rule(const gol_rule* rule) {
+    golRule = *rule;
+}
@@ -0,0 +1,26 @@
+#ifndef GOL_RULE_H
+#define GOL_RULE_H
+
+#include <stdint.h>
+
+// longest rule string, "B012345678/S012345678"
+#define RULE_NAME 24
+
+// an outer totalistic rule: bit n of born (survive) is set when a dead (live) cell
+// with n live neighbours is alive next generation
+typedef struct gol_rule {
+    uint16_t born;
+    uint16_t survive;
+    uint32_t table;         // bit (alive * 9 + neighbours) is the next state, see judgement_day
+    int conway;             // 1 for B3/S23, the kernels then take their hand written path
+    char name[RULE_NAME];   // in B/S notation
+} gol_rule;
+
+// the rule the program steps with, B3/S23 unless set_rule is called (the library
+// passes each engine's own rule to the kernels instead)
+extern gol_rule golRule;
+
+int parse_rule(const char*, gol_rule*);
+void set_rule(const gol_rule*);
+
+#endif
@@ -2,224 +2,517 @@
  * This file allows the simulation to actually run. Simulate board is the driver of the
  * simulation which has the loop and uses the other functions to correctly update the board
  * after each iteration. All of this functionality to go to the n+1th board is defined here, 
- * including different methods for handling wrap vs nowrap.
+ * including the ghost cells that let wrap and nowrap share one update.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include "gol_sim.h"
 #include "gol_io.h"
+#include "gol_swar.h"
+#include "gol_simd.h"
+#include "gol_pool.h"
+#include "gol_tile.h"
+#include "gol_hash.h"
+#include "gol_sparse.h"
+#include "gol_inf.h"
+#include "gol_ckpt.h"
+#include "gol_render.h"
+#include "gol_display.h"
+#include "gol_cycle.h"
+#include "gol_rule.h"
+#include "gol_arena.h"
+#include "gol_export.h"
+#ifdef GOL_STATS
+#include "gol_stats.h"
+#endif
 
-/* simulate_board(int**, int, int, int, int, int, int);
+/* simulate_board(gol_board*, long, const gol_opts*);
  * Simulate board drives most of this program. All of the user input data from command line
  * and from the input file get passed here to be used. Given the specifications for the simulation,
  * it will run, and give proper output, and total excecution time. It utalizes several helper functions
  * so see those function implentations when needed.
- * @param board: 2D int array storing the input board from the user file
- * @param row: int storing number of rows
- * @param col: int storing number of cols
- * @param iter: int storing number of iterations
- * @param wrap: int storing code to wrap or no wrap simulation
- * @param show: int storing code to show or hide the simulation
- * @param speed: int storing frame per second value for output speed (if applicable)
+ * @param board: packed board storing the input board from the user file
+ * @param iter: long storing number of iterations
+ * @param opts: user choices from the command line (wrap, show, speed, engine, threads, tiling)
+ * With tiling, show displays the board once per tile pass (every k generations), and with
+ * hashlife once per jump. With --export-every, passes and jumps stop at every frame.
  */
-void simulate_board(int** board, int row, int col, int iter, int wrap, int show, int speed) {
-    int count = 0;
-    // this is the second board to oscillate between
-    int** flex = create_empty_board(row, col);
+void simulate_board(gol_board* board, long iter, const gol_opts* opts) {
+    long count = 0;
+    int row = board->row, col = board->col;
+    int wrap = opts->wrap, show = opts->show, speed = opts->speed;
+    // function that steps the board one generation
+    int engine = resolve_engine(opts->engine);
+    step_fn step = pick_engine(engine);
+    // with more than one thread, bands of the board are stepped by a worker pool
+    gol_pool* pool = NULL;
+    if (opts->threads > 1) {
+        pool = create_pool(opts->threads, row, pick_row_kernel(engine), wrap);
+    }
+    // with -k, tiles are advanced k generations per pass (see gol_tile.c)
+    gol_tiler* tiler = NULL;
+    if (opts->tile_k > 1) {
+        tiler = create_tiler(board, opts->tile_k, opts->tile_rows, opts->tile_cols, pick_row_kernel(engine));
+    }
+    // hashlife jumps 2^j generations at a time, the last few are stepped normally
+    gol_hash* hash = NULL;
+    if (engine == ENGINE_HASHLIFE) {
+        hash = create_hash(board, opts->hash_mb);
+    }
+    // the sparse engine only steps tiles near the last generation's changes
+    gol_sparse* sparse = NULL;
+    if (engine == ENGINE_SPARSE) {
+        sparse = create_sparse(board);
+    }
+    // infinite keeps live chunks of the plane, the board is just the printed window
+    gol_inf* inf = NULL;
+    if (engine == ENGINE_INFINITE) {
+        inf = create_inf(board);
+    }
+    // with --checkpoint-every, snapshots are written by a background thread
+    gol_ckpt* ckpt = NULL;
+    long every = opts->ckpt_every, gen0 = opts->start_gen;
+    if (every > 0) {
+        ckpt = create_ckpt(board, wrap, gen0 + iter, opts->filename);
+    }
+    // with --export-every, frames are encoded by a background thread (see gol_export.c)
+    gol_export* exporter = NULL;
+    long frameEvery = opts->export_every, lastFrame = gen0;
+    if (frameEvery > 0) {
+        exporter = create_export(board, wrap, frameEvery, opts->filename);
+    }
+    // boards stepped one generation at a time are watched for still lifes and cycles,
+    // hashlife already skips repeats and tile passes move k generations at once. An
+    // exported run needs every Nth generation, so nothing is skipped.
+    int watch = (hash == NULL && tiler == NULL && inf == NULL && exporter == NULL);
+    // the boards the loop steps through share one mapping made up front (see gol_arena.c):
+    // the second board to oscillate between, the loaded board unless it is a mapped
+    // snapshot, and the cycle detector's copy
+    int boards = 1 + (board->map == NULL) + watch;
+    gol_arena* arena = create_arena(boards * arena_board_bytes(row, col));
+    gol_board* flex = arena_board(arena, row, col);
+    if (board->map == NULL) {
+        gol_board* loaded = board;
+        board = arena_board(arena, row, col);
+        memcpy(board->cells, loaded->cells, (size_t)row * board->stride * sizeof(uint64_t));
+        free_array(&loaded);
+    }
+    gol_cycle* cycle = NULL;
+    long skipped = 0;
+    if (watch) {
+        cycle = create_cycle(board, flex, gen0, arena);
+    }
+#ifdef GOL_STATS
+    // with --stats, every step is counted and timed (see gol_stats.c)
+    gol_stats* stats = (opts->stats != NULL) ? create_stats(opts->stats, board, flex) : NULL;
+    struct timespec stepStart, stepEnd;
+#endif
 
     // clear away system to start output
-    system("clear");
+    render_clear();
+    // frames are drawn on their own thread at the requested rate (see gol_display.c)
+    gol_display* display = (show == 1) ? create_display(board, speed) : NULL;
+
+    // the starting board is the first frame, whatever generation it is at
+    if (exporter != NULL) {
+        export_push(exporter, board, gen0);
+    }
 
-    // start clock object
-    struct timeval start, end;
-    gettimeofday(&start, NULL);
+    // start clock object, monotonic so clock adjustments can't skew the timing
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+#ifdef GOL_ALLOCS
+    // heap allocations made by the loop, by any thread (make ALLOCS=1, see gol_arena.c)
+    long allocStart = gol_allocs();
+#endif
     
     // while iter is in range
     while(count < iter) {
-        // if you are showing each output frame
-        if(show == 1) {
-            // print the board
-            print_board(board, row, col);
-            // sleep for 1/fps * 10^6
-            usleep((1.0/speed)*1000000);
-            // clear screen
-            system("clear");            
+        // if you are showing output frames, hand one over whenever it is due
+        if(show == 1 && display_due(display)) {
+            if (inf != NULL) {
+                inf_window(inf, board);
+            }
+            // the sparse engine also shows how much of the board it stepped
+            display_push(display, board, gen0 + count, (sparse != NULL && count > 0) ? sparse->nactive : -1);
+        }
+        // the unbounded plane is stepped in its chunks, the board isn't touched
+        if (inf != NULL) {
+            inf_step(inf);
+            count = count + 1;
+            continue;
+        }
+#ifdef GOL_STATS
+        const gol_board* before = board;
+        if (stats != NULL) {
+            clock_gettime(CLOCK_MONOTONIC, &stepStart);
+        }
+#endif
+        // generations that may go by at once, up to the next frame when exporting
+        long room = iter - count;
+        if (exporter != NULL && frameEvery - (gen0 + count) % frameEvery < room) {
+            room = frameEvery - (gen0 + count) % frameEvery;
+        }
+        // a hashlife jump advances the board in place, no swap needed
+        long advanced = (hash != NULL) ? hash_advance(hash, board, room) : 0;
+        if (advanced < 0) {
+            printf("error: hashlife needs more than %d MB (-m) for this board\n", opts->hash_mb);
+            exit(-1);
+        }
+        if (advanced == 0) {
+            // update the board, a tile pass moves k generations at once
+            advanced = 1;
+            if (tiler != NULL && room >= tiler->k) {
+                tile_pass(tiler, board, flex, wrap);
+                advanced = tiler->k;
+            }
+            else if (pool != NULL) {
+                pool_step(pool, board, flex);
+            }
+            else if (sparse != NULL) {
+                sparse_step(sparse, board, flex, wrap);
+            }
+            else {
+                step(board, flex, wrap);
+            }
+            // swap the boards using pointers
+            swap_board(&board, &flex);
+        }
+#ifdef GOL_STATS
+        if (stats != NULL) {
+            clock_gettime(CLOCK_MONOTONIC, &stepEnd);
+            uint64_t ns = (stepEnd.tv_sec - stepStart.tv_sec) * 1000000000ULL + stepEnd.tv_nsec - stepStart.tv_nsec;
+            // a hashlife jump advanced the board in place and left no copy of it, after a
+            // swap flex holds the board from before the step
+            int swapped = (board != before);
+            // single steps through step_rows counted births and deaths as they went
+            int counted = swapped && advanced == 1 && sparse == NULL && (pool != NULL || engine != ENGINE_SCALAR);
+            stats_step(stats, swapped ? flex : NULL, board, gen0 + count + advanced, advanced, counted, ns);
+        }
+#endif
+        // once the board is known to repeat, every whole period left is skipped
+        if (cycle != NULL && advanced == 1) {
+            // every engine hashed the rows it wrote (the sparse one only those that changed)
+            long period = cycle_check(cycle, board, gen0 + count + 1);
+            if (period > 0) {
+                skipped = (iter - count - 1) / period * period;
+                advanced += skipped;
+            }
         }
-        // update the board
-        update_board(board, flex, row, col, wrap);
-        // swap the boards using pointers
-        swap_board(&board, &flex);
         // update counter
-        count = count + 1;
+        count = count + advanced;
+        // snapshot whenever a multiple of the interval was reached (or jumped past)
+        if (ckpt != NULL && (gen0 + count) / every != (gen0 + count - advanced) / every) {
+            ckpt_save(ckpt, board, gen0 + count);
+        }
+        if (exporter != NULL && (gen0 + count) / frameEvery != (gen0 + count - advanced) / frameEvery) {
+            export_push(exporter, board, gen0 + count);
+            lastFrame = gen0 + count;
+        }
     }
+    // stop clock, the final print below is not part of the simulation
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    // the final board is always the last frame
+    if (exporter != NULL && lastFrame != gen0 + count) {
+        export_push(exporter, board, gen0 + count);
+    }
+#ifdef GOL_ALLOCS
+    long allocRun = gol_allocs() - allocStart;
+#endif
+
     // print final board
-    print_board(board, row, col);    
+    if (inf != NULL) {
+        inf_window(inf, board);
+    }
+    if (display != NULL) {
+        // let the last frame finish drawing before the final board goes out
+        display_finish(display);
+        render_clear();
+    }
+    print_board(board);
 
-    // stop clock and calculate how long it has been
-    gettimeofday(&end, NULL);
-    // Calculate the elapsed time in seconds and microseconds
+    // Calculate the elapsed time in seconds and nanoseconds
     long seconds = end.tv_sec - start.tv_sec;
-    long microseconds = end.tv_usec - start.tv_usec;
-    // If the end microseconds are smaller than the start microseconds, adjust the seconds
-    if (microseconds < 0) {
+    long nanoseconds = end.tv_nsec - start.tv_nsec;
+    // If the end nanoseconds are smaller than the start nanoseconds, adjust the seconds
+    if (nanoseconds < 0) {
         seconds--;
-        microseconds += 1000000;
+        nanoseconds += 1000000000;
     }
 
     // output length of simulation in nice output
-    printf("Total time for %d iterations of %dx%d is %.6f\n", iter, row, col, seconds + microseconds/1000000.0);
+    double elapsed = seconds + nanoseconds/1000000000.0;
+    printf("Total time for %ld iterations of %dx%d is %.6f using %s%s%s\n", iter, row, col,
+           elapsed, engine_name(engine), golRule.conway ? "" : ", rule ", golRule.conway ? "" : golRule.name);
+    printf("Throughput: %.3e cell updates/s on %d thread(s)\n",
+           (double)row * col * iter / elapsed, pool != NULL ? pool->threads : 1);
+#ifdef GOL_ALLOCS
+    printf("Allocations: %ld during the run, boards in %zu bytes of %s pages\n", allocRun, arena->size,
+           arena->huge ? "huge" : "normal");
+#endif
+    if (display != NULL) {
+        printf("Display: %ld frames shown, %ld dropped, latency avg %.3f ms, max %.3f ms\n",
+               display->shown, display->dropped,
+               display->shown > 0 ? display->totalLatency / display->shown * 1000 : 0.0,
+               display->maxLatency * 1000);
+        free_display(&display);
+    }
+
+    if (ckpt != NULL) {
+        // wait for the last snapshot to be on disk before reporting
+        ckpt_finish(ckpt);
+        printf("Checkpoints: %ld written to %s, %ld replaced before they were written\n",
+               ckpt->written, ckpt->path, ckpt->dropped);
+        free_ckpt(&ckpt);
+    }
+    if (exporter != NULL) {
+        // wait for the last frames to be encoded before reporting
+        export_finish(exporter);
+        uint64_t packed = (uint64_t)exporter->frames * row * exporter->words * sizeof(uint64_t);
+        printf("Export: %ld frames to %s, %.3f MB, %.1f%% of the packed boards, the loop waited %ld times\n",
+               exporter->frames, exporter->path, exporter->bytes / 1e6,
+               packed > 0 ? 100.0 * exporter->bytes / packed : 0.0, exporter->waits);
+        free_export(&exporter);
+    }
+    if (pool != NULL) {
+        free_pool(&pool);
+    }
+    if (tiler != NULL) {
+        free_tiler(&tiler);
+    }
+    if (hash != NULL) {
+        printf("HashLife: %ld jumps, %u nodes, %d collections, %d jumps restarted at the -m cap\n", hash->jumps,
+               hash->live, hash->collections, hash->restarts);
+        free_hash(&hash);
+    }
+    if (sparse != NULL) {
+        printf("Active tiles per generation: min %d, avg %.1f, max %d of %d\n", sparse->minActive,
+               sparse->gen > 0 ? (double)sparse->totalActive / sparse->gen : 0.0, sparse->maxActive,
+               sparse->trows * sparse->twords);
+        free_sparse(&sparse);
+    }
+#ifdef GOL_STATS
+    if (stats != NULL) {
+        stats_report(stats);
+    }
+#endif
+    if (cycle != NULL) {
+        if (cycle->period == 1) {
+            printf("Still life from generation %ld, %ld generations skipped\n", cycle->start, skipped);
+        }
+        else if (cycle->period > 1) {
+            printf("Cycle of period %ld from generation %ld, %ld generations skipped\n",
+                   cycle->period, cycle->start, skipped);
+        }
+        free_cycle(&cycle);
+    }
+    if (inf != NULL) {
+        int64_t box[4] = {0, 0, 0, 0};
+        long pop = inf_population(inf, box);
+        printf("Population %ld in %d chunks, live cells span rows %lld to %lld, cols %lld to %lld\n",
+               pop, inf->count, (long long)box[0], (long long)box[2], (long long)box[1], (long long)box[3]);
+        free_inf(&inf);
+    }
+
+    // free memory used within function, the arena takes the boards with it
+    free_array(&flex);
+    free_array(&board);
+    free_arena(&arena);
+#ifdef GOL_STATS
+    // the boards shared its row counts
+    if (stats != NULL) {
+        free_stats(&stats);
+    }
+#endif
+}
 
-    // free memory used within function
-    free_array(&flex, row);
-    free_array(&board, row);
+/* resolve_engine(int);
+ * Resolve engine turns the engine asked for on the command line into the one that will
+ * run. auto checks the CPU (CPUID) and picks the widest vector kernel it supports, or
+ * the portable swar kernel when it has neither. Asking for a vector kernel this CPU
+ * can't run is an error, since its result would be a crash rather than a slow run.
+ * @param engine: ENGINE_* code from the command line
+ * @return: ENGINE_* code of the engine to run (never ENGINE_AUTO)
+ */
+int resolve_engine(int engine) {
+    if (engine == ENGINE_AUTO) {
+        engine = avx512_supported() ? ENGINE_AVX512 : avx2_supported() ? ENGINE_AVX2 : ENGINE_SWAR;
+    }
+    if ((engine == ENGINE_AVX2 && !avx2_supported()) || (engine == ENGINE_AVX512 && !avx512_supported())) {
+        printf("error: engine '%s' is not supported on this CPU\n", engine_name(engine));
+        printf("enter -> (auto/scalar/swar)\n\n");
+        exit(-1);
+    }
+    return engine;
+}
+
+/* pick_engine(int);
+ * Pick engine maps an ENGINE_* code to the function that steps the board. Every engine
+ * takes the same arguments and gives the same result.
+ * @param engine: ENGINE_* code (see resolve_engine for ENGINE_AUTO)
+ * @return: the step function for that engine
+ */
+step_fn pick_engine(int engine) {
+    // one cell at a time reference implementation
+    if (engine == ENGINE_SCALAR) {
+        return update_board;
+    }
+    // 256 and 512 cells at a time
+    if (engine == ENGINE_AVX2) {
+        return update_board_avx2;
+    }
+    if (engine == ENGINE_AVX512) {
+        return update_board_avx512;
+    }
+    // 64 cells at a time, also what hashlife steps the last few generations with
+    // (sparse steps its tiles with swar_word)
+    return update_board_swar;
+}
+
+/* pick_row_kernel(int);
+ * Pick row kernel maps an ENGINE_* code to the kernel that computes one row, which is
+ * what the thread pool runs on every band.
+ * @param engine: ENGINE_* code other than ENGINE_SCALAR and ENGINE_AUTO
+ * @return: the row kernel for that engine
+ */
+row_fn pick_row_kernel(int engine) {
+    if (engine == ENGINE_AVX2) {
+        return avx2_row;
+    }
+    if (engine == ENGINE_AVX512) {
+        return avx512_row;
+    }
+    return swar_row;
+}
+
+/* engine_name(int);
+ * @return: the command line name of an ENGINE_* code
+ */
+const char* engine_name(int engine) {
+    const char* names[] = {"scalar", "swar", "avx2", "avx512", "auto", "hashlife", "sparse", "infinite"};
+    return names[engine];
 }
 
-/* swap_board(int***, int***);
+/* swap_board(gol_board**, gol_board**);
  * swap board allows for the old board and 'flex' board to be swapped. This is useful so that
  * when calling update_board within the sim while loop, the code can always pass one board
- * and swap them after. The function uses int*** pointers so that nothing needs to be returned
- * and all that happens is a pointer swap.
+ * and swap them after. The function uses gol_board** pointers so that nothing needs to be returned
+ * and all that happens is a pointer swap (no cells are copied).
  * @param old: address location of the old (Nth) board
  * @param new: address location of the new (N+1th) board 
  */
-void swap_board(int*** old, int*** new) {
+void swap_board(gol_board** old, gol_board** new) {
     // new board pointer has the data in old
-    int** temp = *old;
+    gol_board* temp = *old;
     // old is now pointing at new
     *old = *new;
     // new is now pointing at old
     *new = temp;
 }
 
-/* update_board(int**, int**, int, int, int);
+/* col_sum(const uint64_t*, const uint64_t*, const uint64_t*, int);
+ * @return: number of live cells in column c of the three rows (0 to 3)
+ */
+static inline int col_sum(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, int c) {
+    int w = c / GOL_WORD_BITS, b = c % GOL_WORD_BITS;
+    return ((up[w] >> b) & 1) + ((mid[w] >> b) & 1) + ((dn[w] >> b) & 1);
+}
+
+/* update_board(const gol_board*, gol_board*, int);
  * Update board is the next iteration of the simulation. Given the old board, the rules of
  * the game are applied to each cell, and its new state (dead or alive) is put into the
- * new board. Wrap is supplied so that the rules can be applied differently for the edge cases. 
- * @param old: 2D int array of the old board
- * @param new: 2D int array of the new board
- * @param row: int storing number of rows for each board (used for loop conditions)
- * @param col: int storing number of cols for each board ("")
+ * new board. The edges are handled with ghost cells filled before the cells are stepped,
+ * so the loop over the cells is the same for wrap and nowrap and has no special cases.
+ * Above the first row and below the last is the opposite row for wrap, and the board's
+ * dead row for nowrap. Each row is stepped from the column sums of the three rows around
+ * it, held in blocks of GHOST_BLOCK columns with a ghost column on each side: the column
+ * from the opposite edge for wrap, 0 for nowrap. The hash of every new row is stored in
+ * new->hashes when it is set (see gol_cycle.c).
+ * @param old: packed board of the old board
+ * @param new: packed board of the new board (same dimensions as old)
  * @param wrap: indicating wether board wraps or not, changing the conditions of the game slightly
  * */
-void update_board(int** old, int** new, int row, int col, int wrap) {
-
-    int sum = 0;
-
-    // check the board / check the interior if wrapped
-    for(int r = 0; r < row; r++) {
-        for(int c = 0; c < col; c++) {
-            sum = old[(r-1+row)%row][(c-1+col)%col] + old[r][(c-1+col)%col] + 
-                  old[(r+1+row)%row][(c-1+col)%col] + old[(r-1+row)%row][c] + 
-                  old[(r+1+row)%row][c] + old[(r-1+row)%row][(c+1+col)%col] + 
-                  old[r][(c+1+col)%col] + old[(r+1+row)%row][(c+1+col)%col];
-            new[r][c] = judgement_day(sum, old[r][c]);
+void update_board(const gol_board* old, gol_board* new, int wrap) {
+
+    int row = old->row, col = old->col;
+    // sums[k] is the column sum of column c0 + k - 1
+    uint8_t sums[GHOST_BLOCK + 2];
+
+    for (int r = 0; r < row; r++) {
+        // ghost rows
+        const uint64_t* up = board_row(old, r > 0 ? r - 1 : (wrap ? row - 1 : row));
+        const uint64_t* mid = board_row(old, r);
+        const uint64_t* dn = board_row(old, r < row - 1 ? r + 1 : (wrap ? 0 : row));
+        uint64_t* out = board_row(new, r);
+        memset(out, 0, old->words * sizeof(uint64_t));
+
+        // ghost columns
+        int right = wrap ? col_sum(up, mid, dn, 0) : 0;
+        sums[0] = wrap ? col_sum(up, mid, dn, col - 1) : 0;
+        sums[1] = col_sum(up, mid, dn, 0);
+
+        for (int c0 = 0; c0 < col; c0 += GHOST_BLOCK) {
+            int n = col - c0 < GHOST_BLOCK ? col - c0 : GHOST_BLOCK;
+            for (int k = 2; k <= n; k++) {
+                sums[k] = col_sum(up, mid, dn, c0 + k - 1);
+            }
+            sums[n + 1] = c0 + n < col ? col_sum(up, mid, dn, c0 + n) : right;
+
+            // every cell of the block, the 3x3 sum less the cell itself
+            for (int k = 0; k < n; k++) {
+                int c = c0 + k;
+                int alive = (mid[c / GOL_WORD_BITS] >> (c % GOL_WORD_BITS)) & 1;
+                int sum = sums[k] + sums[k + 1] + sums[k + 2] - alive;
+                out[c / GOL_WORD_BITS] |= (uint64_t)judgement_day(sum, alive) << (c % GOL_WORD_BITS);
+            }
+            // the last two columns are the first two of the next block
+            sums[0] = sums[n];
+            sums[1] = sums[n + 1];
+        }
+        // hashed while the new row is still in cache, like step_rows does
+        if (new->hashes != NULL) {
+            new->hashes[r] = row_hash(out, new->words, r);
         }
     }
-    
-    // fix border for no wrap
-    if (wrap == 0) {
-        update_nowrap(old, new, row, col);
-    }
-}
-
-/* update_nowrap(int**, int**, int, int)
- * Update nowrap is a function taking the N and N+1 iterations of the board so that
- * every boundary case can be dealt with seperately. Before this function, new stores
- * the board if it were to be wrapped. That is correct for every cell except the border.
- * So, since old is still storing the old board, all calculations for the edge are done
- * and just written over on the new board. A loop is done for the top and bottom row and
- * a loop is done for the left and right edge. Then, the four corners are done manually
- * since they are unique cases.
- * @param old: 2D int array which is the Nth iteration of the board
- * @param new: 2D int array which is the N+1th iteration of the board
- * @param: int storing number of rows
- * @param: int storing number of cols
- */
-void update_nowrap(int** old, int** new, int row, int col) {
-    int sum;
-    row = row-1;
-    col = col-1;
-    // top row and bot row
-    for (int c = 1; c < col - 1; c++) {
-        sum = old[0][c-1] + old[0][c+1] + old[1][c-1] + old[1][c] + old[1][c+1];
-        new[0][c] = judgement_day(sum, old[0][c]);
-        sum = old[row][c-1] + old[row][c+1] + old[row-1][c-1] + old[row-1][c] + old[row-1][c+1];
-        new[row][c] = judgement_day(sum, old[row][c]);
-    }
-    // left and right sides
-    for (int r = 1; r < row - 1; r++) {
-        sum = old[r-1][0] + old[r+1][0] + old[r-1][1] + old[r][1] + old[r+1][1];
-        new[r][0] = judgement_day(sum, old[r][0]);
-        sum = old[r-1][col-1] + old[r][col] + old[r+1][col] + old[r-1][col] + old[r+1][col];
-        new[r][col] = judgement_day(sum, old[r][col]);
-    }
-    // hard code the four corners
-    // top left
-    sum = old[0][1] + old[1][0] + old[1][1];
-    new[0][0] = judgement_day(sum, old[0][0]);
-    // bottom left
-    sum = old[row-1][0] + old[row-1][1] + old[row][1];
-    new[row][0] = judgement_day(sum, old[row][0]);
-    // top right
-    sum = old[0][col-1] + old[1][col-1] + old[1][col];
-    new[0][col] = judgement_day(sum, old[0][col]);
-    // bottom right
-    sum = old[row-1][col-1] + old[row][col-1] + old[row-1][col];
-    new[row][col] = judgement_day(sum, old[row][col]);
 }
 
 /* judgement_day(int, int)
- * Judgement day (cleaverly named) is the function that handle each case for life/death.
- * See the rules for Conway's game of life for rules dictating life/death for next iter of board.
+ * Judgement day (cleaverly named) is the function that decides life/death. The rule
+ * (B3/S23 unless another was given, see gol_rule.c) is compiled into one 18 bit table,
+ * so the answer is a single lookup instead of a chain of branches.
  * @param sum: Stores the number of live cells around the ith, jth cell to figure out state of next iter 
  * @param oldVal: stores old value of ith, jth cell to tell if it was alive or dead.
  * @return: this returns 1 if the cell is to be alive and 0 if the cell is dead in the next iteration.
  */
 int judgement_day(int sum, int oldVal) {
-    int returnVal;
-    // dies from loneliness
-    if (sum < 2 && oldVal == 1) {
-        returnVal = 0;
-    }
-    // overpopulation
-    else if (sum > 3 && oldVal == 1) {
-        returnVal = 0;
-    }
-    // good living conditions
-    else if ((sum == 2 || sum == 3) && oldVal == 1) {
-        returnVal = 1;
-    }
-    // repopulation
-    else if (sum == 3 && oldVal == 0) {
-        returnVal = 1;
-    }
-    // no change
-    else {
-        returnVal = oldVal;
-    }
-    // return dead/alive status
-    return returnVal;
+    // bits 0..8 are dead cells by neighbour count, bits 9..17 live cells
+    return (golRule.table >> (oldVal * 9 + sum)) & 1;
 }
 
-/* free_array(int***, int);
- * Free array takes a pointer to a 2D int array (int**) and the number of rows in that
- * given 2D array (board). It loops through each row and frees the array. Once every row
- * of the board is free, thereby freeing all the data from the board, the array itself
- * is deallocated. 
- * Note: I was getting a bizarre error when passing board without a pointer, so this is
- * the solution I knew would work, and ultimately did work. 
- * @param: a pointer to int** array (board)
- * @param: int storing the number of rows for the given board
+/* free_array(gol_board**);
+ * Free array takes a pointer to a packed board and releases it. All of the cells live
+ * in one buffer, so it is a single free for the cells and one for the board itself.
+ * A board resumed from a snapshot keeps its cells in the mapped file, which is unmapped
+ * instead, and a board carved from an arena is left for free_arena (see gol_arena.c).
+ * The caller's pointer is set to NULL so it can't be used after the free.
+ * @param: a pointer to the gol_board* (board)
  */
-void free_array(int*** array, int row) {
-    // loop through number of rows of this board
-    for(int i = 0; i < row; i++) {
-        // free array at row 'r'
-        free(array[0][i]);
+void free_array(gol_board** array) {
+    if ((*array)->arena != NULL) {
+        *array = NULL;
+        return;
+    }
+    // release the cell buffer, then the board
+    if ((*array)->map != NULL) {
+        munmap((*array)->map, (*array)->mapBytes);
+    }
+    else {
+        free((*array)->cells);
     }
-    // free entire array
     free(*array);
+    *array = NULL;
 }
\ No newline at end of file
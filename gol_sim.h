@@ -1,6 +1,19 @@
-void simulate_board(int**, int, int, int, int, int, int);
-void update_board(int**, int**, int, int, int);
-void update_nowrap(int**, int**, int, int);
+#include "gol_board.h"
+#include "gol_cmd.h"
+#include "gol_swar.h"
+
+// columns update_board steps at a time between ghost columns
+#define GHOST_BLOCK 512
+
+// every engine steps old into new with the same signature as update_board
+typedef void (*step_fn)(const gol_board*, gol_board*, int);
+
+void simulate_board(gol_board*, long, const gol_opts*);
+int resolve_engine(int);
+step_fn pick_engine(int);
+row_fn pick_row_kernel(int);
+const char* engine_name(int);
+void update_board(const gol_board*, gol_board*, int);
 int judgement_day(int, int);
-void swap_board(int***, int***);
-void free_array(int***, int);
\ No newline at end of file
+void swap_board(gol_board**, gol_board**);
+void free_array(gol_board**);
\ No newline at end of file
@@ -0,0 +1,28 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_simd.c
+ * This file checks which vector kernels the CPU can run. It is built without any
+ * vector instruction set, so the check itself runs anywhere; only the kernels in
+ * gol_avx2.c and gol_avx512.c are compiled for AVX2 and AVX-512.
+ */
+#include "gol_simd.h"
+
+/* avx2_supported();
+ * @return: 1 if this CPU can run the AVX2 kernel, 0 if not
+ */
+int avx2_supported(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx2") ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+/* avx512_supported();
+ * @return: 1 if this CPU can run the AVX-512 kernel, 0 if not
+ */
+int avx512_supported(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx512f") ? 1 : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,15 @@
+#ifndef GOL_SIMD_H
+#define GOL_SIMD_H
+
+#include "gol_board.h"
+#include "gol_rule.h"
+
+int avx2_supported(void);
+void avx2_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+void update_board_avx2(const gol_board*, gol_board*, int);
+
+int avx512_supported(void);
+void avx512_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+void update_board_avx512(const gol_board*, gol_board*, int);
+
+#endif
@@ -0,0 +1,163 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_sparse.c
+ * This file is the sparse engine, for boards that are mostly dead space or still lifes.
+ * The board is cut into tiles of 64 rows by one word. A tile can only change next
+ * generation if it or one of its eight neighbours changed this generation, so only
+ * those tiles are stepped, and the cost follows the activity on the board instead of
+ * its area. Skipped tiles need no copy either: a tile that did not change holds the
+ * same cells in both boards, since the last swap_board left the previous (equal)
+ * generation behind it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_sparse.h"
+#include "gol_swar.h"
+
+/* create_sparse(const gol_board*);
+ * Create sparse sets up tile tracking for a board. Every tile starts out as changed,
+ * so the first generation steps the whole board and fills in both boards.
+ * @param board: the board that will be stepped
+ * @return: the sparse engine
+ */
+gol_sparse* create_sparse(const gol_board* board) {
+    gol_sparse* sp = malloc(sizeof(gol_sparse));
+    if (sp == NULL) {
+        printf("error: unable to allocate the sparse engine\n");
+        exit(-1);
+    }
+    sp->trows = (board->row + SPARSE_TILE_ROWS - 1) / SPARSE_TILE_ROWS;
+    sp->twords = board->words;
+    int tiles = sp->trows * sp->twords;
+    sp->changed = malloc(tiles * sizeof(int));
+    sp->next = malloc(tiles * sizeof(int));
+    sp->active = malloc(tiles * sizeof(int));
+    sp->stamp = calloc(tiles, sizeof(uint64_t));
+    sp->rehashed = calloc(sp->trows, sizeof(uint64_t));
+    if (sp->changed == NULL || sp->next == NULL || sp->active == NULL || sp->stamp == NULL || sp->rehashed == NULL) {
+        printf("error: unable to allocate the sparse engine's %d tiles\n", tiles);
+        exit(-1);
+    }
+    for (int t = 0; t < tiles; t++) {
+        sp->changed[t] = t;
+    }
+    sp->nchanged = tiles;
+    sp->gen = 0;
+    sp->totalActive = 0;
+    sp->minActive = tiles;
+    sp->maxActive = 0;
+    return sp;
+}
+
+/* gather_active(gol_sparse*, int);
+ * Fills the active list with every tile that changed last generation and its eight
+ * neighbours (across the edges with wrap), each tile listed once.
+ */
+static void gather_active(gol_sparse* sp, int wrap) {
+    sp->nactive = 0;
+    sp->gen++;
+    for (int i = 0; i < sp->nchanged; i++) {
+        int tr = sp->changed[i] / sp->twords, tw = sp->changed[i] % sp->twords;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dw = -1; dw <= 1; dw++) {
+                int r = tr + dr, w = tw + dw;
+                if (wrap) {
+                    r = (r + sp->trows) % sp->trows;
+                    w = (w + sp->twords) % sp->twords;
+                }
+                else if (r < 0 || r >= sp->trows || w < 0 || w >= sp->twords) {
+                    continue;
+                }
+                int t = r * sp->twords + w;
+                if (sp->stamp[t] != sp->gen) {
+                    sp->stamp[t] = sp->gen;
+                    sp->active[sp->nactive++] = t;
+                }
+            }
+        }
+    }
+}
+
+/* step_tile(const gol_board*, gol_board*, int, int, int);
+ * Steps the 64 rows of one word that make up a tile.
+ * @return: 1 if any cell of the tile changed, 0 if not
+ */
+static int step_tile(const gol_board* old, gol_board* new, int tr, int w, int wrap) {
+    int row = old->row;
+    int r1 = (tr + 1) * SPARSE_TILE_ROWS < row ? (tr + 1) * SPARSE_TILE_ROWS : row;
+    const uint64_t* dead = board_row(old, row);
+    uint64_t diff = 0;
+
+    for (int r = tr * SPARSE_TILE_ROWS; r < r1; r++) {
+        const uint64_t* up = (r > 0) ? board_row(old, r-1) : wrap ? board_row(old, row-1) : dead;
+        const uint64_t* dn = (r < row-1) ? board_row(old, r+1) : wrap ? board_row(old, 0) : dead;
+        const uint64_t* mid = board_row(old, r);
+        uint64_t out = swar_word(up, mid, dn, w, old->col, wrap, &golRule);
+        diff |= out ^ mid[w];
+        board_row(new, r)[w] = out;
+    }
+    return diff != 0;
+}
+
+/* rehash_rows(gol_sparse*, gol_board*);
+ * Rehashes the rows of every tile row holding a tile that changed, once per tile row.
+ * Every other row holds the same cells as last generation, so its hash still stands.
+ */
+static void rehash_rows(gol_sparse* sp, gol_board* new) {
+    for (int i = 0; i < sp->nnext; i++) {
+        int tr = sp->next[i] / sp->twords;
+        if (sp->rehashed[tr] == sp->gen) {
+            continue;
+        }
+        sp->rehashed[tr] = sp->gen;
+        int r1 = (tr + 1) * SPARSE_TILE_ROWS < new->row ? (tr + 1) * SPARSE_TILE_ROWS : new->row;
+        for (int r = tr * SPARSE_TILE_ROWS; r < r1; r++) {
+            new->hashes[r] = row_hash(board_row(new, r), new->words, r);
+        }
+    }
+}
+
+/* sparse_step(gol_sparse*, const gol_board*, gol_board*, int);
+ * Steps only the tiles that can change, and records which of them did for the next
+ * generation along with the number of tiles stepped. The row hashes in new->hashes,
+ * when it is set, are brought up to date for the rows that changed (see gol_cycle.c),
+ * so the cost stays with the activity.
+ * @param sp: the sparse engine
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+void sparse_step(gol_sparse* sp, const gol_board* old, gol_board* new, int wrap) {
+    gather_active(sp, wrap);
+    sp->nnext = 0;
+    for (int i = 0; i < sp->nactive; i++) {
+        int t = sp->active[i];
+        if (step_tile(old, new, t / sp->twords, t % sp->twords, wrap)) {
+            sp->next[sp->nnext++] = t;
+        }
+    }
+    if (new->hashes != NULL) {
+        rehash_rows(sp, new);
+    }
+    // the tiles that changed now are the ones to look around next generation
+    int* swap = sp->changed;
+    sp->changed = sp->next;
+    sp->next = swap;
+    sp->nchanged = sp->nnext;
+
+    sp->totalActive += sp->nactive;
+    sp->minActive = (sp->nactive < sp->minActive) ? sp->nactive : sp->minActive;
+    sp->maxActive = (sp->nactive > sp->maxActive) ? sp->nactive : sp->maxActive;
+}
+
+/* free_sparse(gol_sparse**);
+ * Frees the tile lists and the engine, and sets the caller's pointer to NULL
+ */
+void free_sparse(gol_sparse** psp) {
+    free((*psp)->changed);
+    free((*psp)->next);
+    free((*psp)->active);
+    free((*psp)->stamp);
+    free((*psp)->rehashed);
+    free(*psp);
+    *psp = NULL;
+}
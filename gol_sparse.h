@@ -0,0 +1,31 @@
+#ifndef GOL_SPARSE_H
+#define GOL_SPARSE_H
+
+#include "gol_board.h"
+
+// rows in a tile, a tile is this many rows of one word (64 columns)
+#define SPARSE_TILE_ROWS 64
+
+// active region tracking for boards that are mostly dead or still
+typedef struct gol_sparse {
+    int trows;          // tiles down the board
+    int twords;         // tiles across the board (one per word)
+    int* changed;       // tiles that changed in the last generation
+    int nchanged;
+    int* next;          // tiles changing in the generation being stepped
+    int nnext;
+    int* active;        // tiles stepped this generation
+    int nactive;
+    uint64_t* stamp;    // generation a tile was last put in active, to skip duplicates (never wraps)
+    uint64_t* rehashed; // generation the rows of a tile row were last rehashed
+    uint64_t gen;       // generations stepped so far
+    long totalActive;   // sum of nactive over every generation
+    int minActive;      // fewest tiles stepped in one generation
+    int maxActive;      // most tiles stepped in one generation
+} gol_sparse;
+
+gol_sparse* create_sparse(const gol_board*);
+void sparse_step(gol_sparse*, const gol_board*, gol_board*, int);
+void free_sparse(gol_sparse**);
+
+#endif
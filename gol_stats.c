@@ -0,0 +1,253 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_stats.c
+ * This file records what happens in every generation: the population, the cells born
+ * and the cells that died, and how long the step took. It is only built with
+ * make STATS=1 (GOL_STATS), so a normal build carries none of it.
+ * The row kernels count births and deaths with two popcounts per word while the rows
+ * are still in cache (see step_rows), and the population is kept up to date from them,
+ * so a generation costs a sum over the rows rather than another pass over the board.
+ * Engines that don't go through step_rows (scalar, tiled passes, sparse) are counted by
+ * comparing the two boards, and hashlife jumps only report the population.
+ * One line per step, "generation population births deaths step_ns", is streamed to a
+ * file or to a unix socket (unix:<path>), flushed a few times a second. Step times are
+ * also kept in a log-linear histogram, summarized at the end of the run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gol_stats.h"
+
+/* now_seconds();
+ * @return: seconds on the monotonic clock
+ */
+static double now_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* bucket_of(uint64_t);
+ * @return: histogram bucket of a time in nanoseconds. Times below 2^STATS_SUB_BITS get
+ * a bucket each, above that every power of 2 is split into 2^STATS_SUB_BITS buckets.
+ */
+static int bucket_of(uint64_t ns) {
+    if (ns < (1 << STATS_SUB_BITS)) {
+        return (int)ns;
+    }
+    int e = 63 - __builtin_clzll(ns);
+    int sub = (ns >> (e - STATS_SUB_BITS)) & ((1 << STATS_SUB_BITS) - 1);
+    return ((e - STATS_SUB_BITS + 1) << STATS_SUB_BITS) + sub;
+}
+
+/* bucket_low(int);
+ * @return: smallest time in nanoseconds that falls in bucket b
+ */
+static uint64_t bucket_low(int b) {
+    if (b < (1 << STATS_SUB_BITS)) {
+        return b;
+    }
+    int e = (b >> STATS_SUB_BITS) + STATS_SUB_BITS - 1;
+    uint64_t sub = b & ((1 << STATS_SUB_BITS) - 1);
+    return ((1ULL << STATS_SUB_BITS) + sub) << (e - STATS_SUB_BITS);
+}
+
+/* percentile(const gol_stats*, double);
+ * @return: upper edge of the bucket holding the q'th fraction of the step times
+ * (never more than the slowest step)
+ */
+static uint64_t percentile(const gol_stats* stats, double q) {
+    long want = (long)(q * stats->steps);
+    if (want >= stats->steps) {
+        want = stats->steps - 1;
+    }
+    long seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += stats->hist[b];
+        if (seen > want) {
+            uint64_t high = (b + 1 < STATS_BUCKETS) ? bucket_low(b + 1) - 1 : UINT64_MAX;
+            return high < stats->maxNs ? high : stats->maxNs;
+        }
+    }
+    return stats->maxNs;
+}
+
+/* open_stream(char*);
+ * Opens where the per generation lines go: unix:<path> connects to a listening unix
+ * stream socket, anything else is a file that is created or truncated.
+ * @return: the stream
+ */
+static FILE* open_stream(char* where) {
+    if (strncmp(where, "unix:", 5) != 0) {
+        FILE* out = fopen(where, "w");
+        if (out == NULL) {
+            printf("error: unable to open stats file '%s'\n", where);
+            exit(-1);
+        }
+        return out;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(where + 5) >= sizeof(addr.sun_path)) {
+        printf("error: stats socket path '%s' is too long\n", where + 5);
+        exit(-1);
+    }
+    strcpy(addr.sun_path, where + 5);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("error: unable to connect to stats socket '%s'\n", where + 5);
+        exit(-1);
+    }
+    // a reader that goes away must not kill the run, the write just fails
+    signal(SIGPIPE, SIG_IGN);
+    return fdopen(fd, "w");
+}
+
+/* create_stats(char*, gol_board*, gol_board*);
+ * Create stats opens the stream, counts the starting population and gives both boards
+ * the per row counts the kernels fill in.
+ * @param where: file name, or unix:<path> for a unix socket
+ * @param board: board at the start of the run
+ * @param flex: the other board the run swaps with
+ * @return: the recorder
+ */
+gol_stats* create_stats(char* where, gol_board* board, gol_board* flex) {
+    gol_stats* stats = calloc(1, sizeof(gol_stats));
+    gol_counts* counts = calloc(board->row, sizeof(gol_counts));
+    if (stats == NULL || counts == NULL) {
+        printf("error: unable to allocate stats for %d rows\n", board->row);
+        exit(-1);
+    }
+    stats->where = where;
+    stats->row = board->row;
+    stats->counts = counts;
+    board->counts = stats->counts;
+    flex->counts = stats->counts;
+    for (int r = 0; r < board->row; r++) {
+        const uint64_t* cells = board_row(board, r);
+        for (int w = 0; w < board->words; w++) {
+            stats->population += __builtin_popcountll(cells[w]);
+        }
+    }
+    stats->out = open_stream(where);
+    fprintf(stats->out, "# generation population births deaths step_ns\n");
+    stats->lastFlush = now_seconds();
+    return stats;
+}
+
+/* stats_step(gol_stats*, const gol_board*, const gol_board*, long, long, int, uint64_t);
+ * Records one step of the run and streams its line.
+ * @param stats: the recorder
+ * @param old: board before the step, NULL when it was advanced in place (hashlife)
+ * @param new: board after the step
+ * @param gen: generation the board is at now
+ * @param advanced: generations the step moved
+ * @param counted: 1 if the kernels filled in new->counts during this step
+ * @param ns: nanoseconds the step took
+ */
+void stats_step(gol_stats* stats, const gol_board* old, const gol_board* new, long gen, long advanced,
+                int counted, uint64_t ns) {
+    long births = 0, deaths = 0;
+    if (counted) {
+        for (int r = 0; r < stats->row; r++) {
+            births += stats->counts[r].births;
+            deaths += stats->counts[r].deaths;
+        }
+        stats->population += births - deaths;
+    }
+    else if (old != NULL && advanced == 1) {
+        // compare the boards when the engine didn't count as it went
+        for (int r = 0; r < stats->row; r++) {
+            const uint64_t* before = board_row(old, r);
+            const uint64_t* after = board_row(new, r);
+            for (int w = 0; w < new->words; w++) {
+                births += __builtin_popcountll(after[w] & ~before[w]);
+                deaths += __builtin_popcountll(before[w] & ~after[w]);
+            }
+        }
+        stats->population += births - deaths;
+    }
+    else {
+        // several generations at once: births and deaths in between are unknown
+        births = deaths = -1;
+        stats->population = 0;
+        for (int r = 0; r < new->row; r++) {
+            const uint64_t* cells = board_row(new, r);
+            for (int w = 0; w < new->words; w++) {
+                stats->population += __builtin_popcountll(cells[w]);
+            }
+        }
+    }
+    if (births >= 0) {
+        stats->births += births;
+        stats->deaths += deaths;
+    }
+
+    // the histogram holds time per generation so tile passes and jumps compare with steps
+    uint64_t per = ns / advanced;
+    stats->hist[bucket_of(per)]++;
+    stats->steps++;
+    if (per > stats->maxNs) {
+        stats->maxNs = per;
+    }
+
+    if (stats->out != NULL) {
+        if (fprintf(stats->out, "%ld %ld %ld %ld %llu\n", gen, stats->population, births, deaths,
+                    (unsigned long long)ns) < 0) {
+            printf("error: writing stats to '%s' failed, no more stats are streamed\n", stats->where);
+            fclose(stats->out);
+            stats->out = NULL;
+            return;
+        }
+        double now = now_seconds();
+        if (now - stats->lastFlush >= STATS_FLUSH_SECONDS) {
+            fflush(stats->out);
+            stats->lastFlush = now;
+        }
+    }
+}
+
+/* stats_report(gol_stats*);
+ * Prints the step time percentiles and the totals, and appends the histogram to the
+ * stream as "# hist low_ns steps" lines.
+ * @param stats: the recorder
+ */
+void stats_report(gol_stats* stats) {
+    if (stats->steps == 0) {
+        return;
+    }
+    printf("Step time per generation: p50 %llu ns, p90 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n",
+           (unsigned long long)percentile(stats, 0.5), (unsigned long long)percentile(stats, 0.9),
+           (unsigned long long)percentile(stats, 0.99), (unsigned long long)percentile(stats, 0.999),
+           (unsigned long long)stats->maxNs);
+    printf("Population %ld, %ld births and %ld deaths over %ld steps, streamed to %s\n",
+           stats->population, stats->births, stats->deaths, stats->steps, stats->where);
+    if (stats->out != NULL) {
+        for (int b = 0; b < STATS_BUCKETS; b++) {
+            if (stats->hist[b] > 0) {
+                fprintf(stats->out, "# hist %llu %llu\n", (unsigned long long)bucket_low(b),
+                        (unsigned long long)stats->hist[b]);
+            }
+        }
+        fflush(stats->out);
+    }
+}
+
+/* free_stats(gol_stats**);
+ * Closes the stream, frees the recorder and sets the caller's pointer to NULL. The
+ * boards given to create_stats must not be stepped afterwards.
+ * @param ps: pointer to the gol_stats*
+ */
+void free_stats(gol_stats** ps) {
+    gol_stats* stats = *ps;
+    if (stats->out != NULL) {
+        fclose(stats->out);
+    }
+    free(stats->counts);
+    free(stats);
+    *ps = NULL;
+}
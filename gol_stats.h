@@ -0,0 +1,33 @@
+#ifndef GOL_STATS_H
+#define GOL_STATS_H
+
+#include <stdio.h>
+#include "gol_board.h"
+
+// log-linear histogram of step times: every power of 2 nanoseconds is split into
+// 2^STATS_SUB_BITS equal buckets, so any time is known to within 12.5%
+#define STATS_SUB_BITS 3
+#define STATS_BUCKETS (64 << STATS_SUB_BITS)
+// seconds between flushes of the stream, so a reader sees a long run as it goes
+#define STATS_FLUSH_SECONDS 0.1
+
+// per generation instrumentation, only built with GOL_STATS (make STATS=1)
+typedef struct gol_stats {
+    FILE* out;              // per generation lines, NULL after a failed write
+    char* where;            // file name or unix:<socket path>
+    gol_counts* counts;     // one per row, shared by both boards
+    int row;
+    long population;        // live cells now
+    long births, deaths;    // totals over the run
+    uint64_t hist[STATS_BUCKETS];
+    long steps;             // steps in the histogram
+    uint64_t maxNs;         // slowest generation
+    double lastFlush;       // when the stream was last flushed
+} gol_stats;
+
+gol_stats* create_stats(char*, gol_board*, gol_board*);
+void stats_step(gol_stats*, const gol_board*, const gol_board*, long, long, int, uint64_t);
+void stats_report(gol_stats*);
+void free_stats(gol_stats**);
+
+#endif
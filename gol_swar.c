@@ -0,0 +1,230 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_swar.c
+ * This file is the bit-parallel (SWAR, SIMD within a register) version of update_board.
+ * Instead of adding up eight neighbours one cell at a time, the eight neighbour bitplanes
+ * of a whole 64-bit word are added with full-adder logic, so 64 cells get their next
+ * state from a handful of bitwise operations. update_board in gol_sim.c stays as the
+ * reference that this kernel is checked against. Rules other than B3/S23 (see gol_rule.c)
+ * finish the count into four planes and match it against the rule's masks.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "gol_swar.h"
+#include "gol_rule.h"
+
+/* full_add(uint64_t, uint64_t, uint64_t, uint64_t*, uint64_t*);
+ * Adds three bitplanes column by column. Every bit of sum/carry is the low/high bit
+ * of the count of ones in that position of a, b and c.
+ */
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t* sum, uint64_t* carry) {
+    uint64_t t = a ^ b;
+    *sum = t ^ c;
+    *carry = (a & b) | (t & c);
+}
+
+/* rule_word(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, unsigned, unsigned);
+ * Applies any rule to 64 cells whose neighbour counts are given as the planes ones,
+ * twos, fours and eights. Each count from 0 to 8 is matched as the AND of one of four
+ * low plane patterns and one of three high ones, and the matches in born (dead cells)
+ * and survive (live cells) are ORed together. With born and survive known at compile
+ * time, the counts outside the rule drop out.
+ * @param m: the cells themselves
+ * @return: the 64 cells of the next generation
+ */
+static inline uint64_t rule_word(uint64_t ones, uint64_t twos, uint64_t fours, uint64_t eights,
+                                 uint64_t m, unsigned born, unsigned survive) {
+    uint64_t lo[4] = {~(ones | twos), ones & ~twos, twos & ~ones, ones & twos};
+    uint64_t hi[3] = {~(fours | eights), fours, eights};
+    uint64_t b = 0, s = 0;
+    for (int k = 0; k <= 8; k++) {
+        uint64_t eq = lo[k & 3] & hi[k >> 2];
+        b |= eq & -(uint64_t)((born >> k) & 1);
+        s |= eq & -(uint64_t)((survive >> k) & 1);
+    }
+    return (s & m) | (b & ~m);
+}
+
+/* life_word(nine uint64_t bitplanes, int, unsigned, unsigned);
+ * Applies the rule to 64 cells at once. The neighbour count of every cell is built up
+ * as bitplanes (ones, twos, fours). For B3/S23 a cell is alive next generation when its
+ * count is 3, or when it is 2 and the cell is alive now; a count of 8 carries out of
+ * the fours plane, so it reads as "4 or more" and correctly dies. Other rules split the
+ * carries into fours and eights and go through rule_word.
+ * @param uw, u, ue: row above shifted so each bit holds its west, centre and east neighbour
+ * @param mw, m, me: current row, m itself is the cell and is not counted
+ * @param dw, d, de: row below, same as the row above
+ * @param conway: 1 for B3/S23 (a constant at every call, so each path is compiled apart)
+ * @param born, survive: masks of the rule when conway is 0
+ * @return: the 64 cells of the next generation
+ */
+static inline uint64_t life_word(uint64_t uw, uint64_t u, uint64_t ue, uint64_t mw, uint64_t m,
+                                 uint64_t me, uint64_t dw, uint64_t d, uint64_t de,
+                                 int conway, unsigned born, unsigned survive) {
+    uint64_t su, cu, sd, cd, ones, c4, t1, f1, twos, f2;
+    // count the row above and below, 0..3 each
+    full_add(uw, u, ue, &su, &cu);
+    full_add(dw, d, de, &sd, &cd);
+    // the current row only has the two side neighbours (half adder)
+    uint64_t sm = mw ^ me, cm = mw & me;
+    // ones plane and its carry
+    full_add(su, sd, sm, &ones, &c4);
+    // add the four carries into the twos plane, anything past it is 4 or more
+    full_add(cu, cd, cm, &t1, &f1);
+    twos = t1 ^ c4;
+    f2 = t1 & c4;
+    if (conway) {
+        return twos & ~(f1 | f2) & (ones | m);
+    }
+    // f1 and f2 are both set only for a count of 8
+    return rule_word(ones, twos, f1 ^ f2, f1 & f2, m, born, survive);
+}
+
+/* shift_row(const uint64_t*, int, int, int, int, uint64_t*, uint64_t*);
+ * Builds the west and east neighbour planes for word w of a row. The bits shifted in at
+ * each end of the word come from the neighbouring words, or for the first and last
+ * word of the row from the opposite edge of the board (wrap) or a dead cell (nowrap).
+ * @param row: the packed row
+ * @param w: index of the word
+ * @param last: index of the last word holding cells
+ * @param top: bit position of the last column within the last word
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+static inline void shift_row(const uint64_t* row, int w, int last, int top, int wrap,
+                             uint64_t* west, uint64_t* east) {
+    uint64_t x = row[w];
+    uint64_t win = (w > 0) ? row[w-1] >> 63 : (uint64_t)wrap & (row[last] >> top);
+    uint64_t ein = (w < last) ? row[w+1] << 63 : ((uint64_t)wrap & row[0]) << top;
+    *west = (x << 1) | win;
+    *east = (x >> 1) | ein;
+}
+
+/* next_word(const uint64_t*, const uint64_t*, const uint64_t*, int, int, int, int, int, unsigned, unsigned);
+ * Computes word w of the next generation of the middle row.
+ * @param up, mid, dn: rows above, at and below the row being updated
+ * @param w: index of the word
+ * @param last: index of the last word holding cells
+ * @param top: bit position of the last column within the last word
+ * @param wrap: 1 to wrap around the board horizontally, 0 for dead edges
+ * @param conway, born, survive: the rule, see life_word
+ */
+static inline uint64_t next_word(const uint64_t* up, const uint64_t* mid, const uint64_t* dn,
+                                 int w, int last, int top, int wrap,
+                                 int conway, unsigned born, unsigned survive) {
+    uint64_t uw, ue, mw, me, dw, de;
+    shift_row(up, w, last, top, wrap, &uw, &ue);
+    shift_row(mid, w, last, top, wrap, &mw, &me);
+    shift_row(dn, w, last, top, wrap, &dw, &de);
+    return life_word(uw, up[w], ue, mw, mid[w], me, dw, dn[w], de, conway, born, survive);
+}
+
+/* swar_word(const uint64_t*, const uint64_t*, const uint64_t*, int, int, int, const gol_rule*);
+ * Single word version of swar_row, used by the vector kernels to patch up the words at
+ * each end of a row, where bits come in from the opposite edge. Padding bits of the
+ * last word are cleared.
+ * @param up, mid, dn: rows above, at and below the row being updated
+ * @param w: index of the word
+ * @param col: number of columns in the row
+ * @param wrap: 1 to wrap around the board horizontally, 0 for dead edges
+ * @param rule: the rule to step with
+ * @return: word w of the new row
+ */
+uint64_t swar_word(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, int w, int col, int wrap,
+                   const gol_rule* rule) {
+    int last = (col - 1) / GOL_WORD_BITS;
+    int top = (col - 1) % GOL_WORD_BITS;
+    uint64_t out = rule->conway ? next_word(up, mid, dn, w, last, top, wrap, 1, 0, 0)
+                                : next_word(up, mid, dn, w, last, top, wrap, 0, rule->born, rule->survive);
+    return (w == last) ? out & (~(uint64_t)0 >> (GOL_WORD_BITS - 1 - top)) : out;
+}
+
+/* swar_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+ * Computes one row of the next generation from the rows above, at and below it.
+ * Bits past the last column are cleared so padding stays dead.
+ * @param up: row above (a dead row for the top edge with nowrap)
+ * @param mid: the row being updated
+ * @param dn: row below (a dead row for the bottom edge with nowrap)
+ * @param out: where the new row is written
+ * @param col: number of columns in the row
+ * @param wrap: 1 to wrap around the board horizontally, 0 for dead edges
+ * @param rule: the rule to step with
+ */
+void swar_row(const uint64_t* up, const uint64_t* mid, const uint64_t* dn, uint64_t* out,
+              int col, int wrap, const gol_rule* rule) {
+    int last = (col - 1) / GOL_WORD_BITS;
+    int top = (col - 1) % GOL_WORD_BITS;
+
+    // the rule is checked once per row, each loop has its logic compiled in
+    if (rule->conway) {
+        for (int w = 0; w <= last; w++) {
+            out[w] = next_word(up, mid, dn, w, last, top, wrap, 1, 0, 0);
+        }
+    }
+    else {
+        unsigned born = rule->born, survive = rule->survive;
+        for (int w = 0; w <= last; w++) {
+            out[w] = next_word(up, mid, dn, w, last, top, wrap, 0, born, survive);
+        }
+    }
+    // clear anything the shifts pushed into the padding
+    out[last] &= ~(uint64_t)0 >> (GOL_WORD_BITS - 1 - top);
+}
+
+#ifdef GOL_STATS
+/* count_row(const uint64_t*, const uint64_t*, int, gol_counts*);
+ * Counts the cells born and the cells that died between a row and its next generation,
+ * while both rows are still in cache from the kernel.
+ */
+static inline void count_row(const uint64_t* before, const uint64_t* after, int words, gol_counts* counts) {
+    uint32_t births = 0, deaths = 0;
+    for (int w = 0; w < words; w++) {
+        births += __builtin_popcountll(after[w] & ~before[w]);
+        deaths += __builtin_popcountll(before[w] & ~after[w]);
+    }
+    counts->births = births;
+    counts->deaths = deaths;
+}
+#endif
+
+/* step_rows(row_fn, const gol_board*, gol_board*, int, int, int, const gol_rule*);
+ * Runs a row kernel for rows r0 up to (not including) r1. With nowrap the rows above
+ * the first and below the last row are the board's dead row. In a GOL_STATS build,
+ * births and deaths of every row are stored in new->counts when it is set. The hash of
+ * every new row is stored in new->hashes when it is set (see gol_cycle.c).
+ * @param kernel: function computing one new row (swar_row or one of the vector kernels)
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ * @param r0: first row to update
+ * @param r1: one past the last row to update
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ * @param rule: the rule to step with, handed to the kernel
+ */
+void step_rows(row_fn kernel, const gol_board* old, gol_board* new, int r0, int r1, int wrap,
+               const gol_rule* rule) {
+    int row = old->row;
+    const uint64_t* dead = board_row(old, row);
+
+    for (int r = r0; r < r1; r++) {
+        const uint64_t* up = (r > 0) ? board_row(old, r-1) : wrap ? board_row(old, row-1) : dead;
+        const uint64_t* dn = (r < row-1) ? board_row(old, r+1) : wrap ? board_row(old, 0) : dead;
+        kernel(up, board_row(old, r), dn, board_row(new, r), old->col, wrap, rule);
+        // hashed while the new row is still in cache
+        if (new->hashes != NULL) {
+            new->hashes[r] = row_hash(board_row(new, r), new->words, r);
+        }
+#ifdef GOL_STATS
+        if (new->counts != NULL) {
+            count_row(board_row(old, r), board_row(new, r), old->words, &new->counts[r]);
+        }
+#endif
+    }
+}
+
+/* update_board_swar(const gol_board*, gol_board*, int);
+ * Bit-parallel replacement for update_board, same arguments and same result.
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+1th iteration is written to
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+void update_board_swar(const gol_board* old, gol_board* new, int wrap) {
+    step_rows(swar_row, old, new, 0, old->row, wrap, &golRule);
+}
@@ -0,0 +1,15 @@
+#ifndef GOL_SWAR_H
+#define GOL_SWAR_H
+
+#include "gol_board.h"
+#include "gol_rule.h"
+
+// computes one new row from the rows above, at and below it (see swar_row)
+typedef void (*row_fn)(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+
+void update_board_swar(const gol_board*, gol_board*, int);
+void step_rows(row_fn, const gol_board*, gol_board*, int, int, int, const gol_rule*);
+void swar_row(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, int, int, const gol_rule*);
+uint64_t swar_word(const uint64_t*, const uint64_t*, const uint64_t*, int, int, int, const gol_rule*);
+
+#endif
@@ -0,0 +1,100 @@
+#!/bin/sh
+# Ethan Perry - Project 1: Conway's Game of Life - gol_test.sh
+# Run by make test. Steps the bundled patterns with every engine the CPU has, and in
+# small tiles (-k, see gol_tile.c), and checks that each one prints the same boards as
+# the scalar reference, for wrap and nowrap. Then checks with print_allocs (print
+# counting its heap allocations, see gol_arena.c) that the default engine makes none
+# while the board is stepped, that an exported run keeps every frame, that a batch runs
+# past a bad file, and last runs the library checks of gol_libtest.c and compares the
+# boards the library steps with print's.
+# Prints one line per failed check and exits with 1 if there was any.
+cd "$(dirname "$0")" || exit 1
+fail=0
+ref=$(mktemp)
+out=$(mktemp)
+pat=$(mktemp)
+trap 'rm -f "$ref" "$out" "$pat" "$pat.frames"' EXIT
+
+# boards a run prints, without the timing lines
+boards() {
+    ./print "$@" | grep -E '^[-@]+$'
+}
+
+# the vector engines are left out on a CPU that can't run them
+engines="swar"
+for e in avx2 avx512; do
+    if ./print glidergun.txt wrap hide -n 0 -e $e > /dev/null; then
+        engines="$engines $e"
+    fi
+done
+
+for f in glidergun.txt pentadec.txt spaceship.txt; do
+    for w in wrap nowrap; do
+        boards $f $w hide -e scalar > "$ref"
+        for e in $engines; do
+            boards $f $w hide -e $e > "$out"
+            if ! cmp -s "$ref" "$out"; then
+                echo "FAIL: $f $w, $e differs from scalar"
+                fail=1
+            fi
+        done
+        # tiles smaller than the board, so halos come from the other side or are dead
+        for k in 2 5; do
+            boards $f $w hide -k $k -T 8x64 > "$out"
+            if ! cmp -s "$ref" "$out"; then
+                echo "FAIL: $f $w, -k $k differs from scalar"
+                fail=1
+            fi
+        done
+    done
+done
+
+# the loop only steps boards carved from the arena, on one thread and on several
+for f in glidergun.txt pentadec.txt spaceship.txt; do
+    for w in wrap nowrap; do
+        for t in 1 4; do
+            if ! ./print_allocs $f $w hide -t $t | grep -q "^Allocations: 0 during the run"; then
+                echo "FAIL: $f $w -t $t, allocated during the run"
+                fail=1
+            fi
+        done
+    done
+done
+
+# an oscillator would be skipped by cycle detection and jumped by hashlife, an exported
+# run must still keep every generation
+cp oscillator.txt "$pat"
+for e in swar hashlife; do
+    ./print "$pat" wrap hide -n 100 -e $e --export-every 1 > /dev/null
+    if ! ./print --replay "$pat.frames" hide | grep -q "^Replayed 101 frames"; then
+        echo "FAIL: oscillator.txt -e $e --export-every 1, frames missing"
+        fail=1
+    fi
+done
+
+# a batch goes on past a file it can not load and reports it in that file's line
+printf 'missing.txt\nglidergun.txt\n' > "$pat"
+./print --batch "$pat" wrap -t 2 > "$out"
+if ! grep -q "^missing.txt error: " "$out" || ! grep -q "^glidergun.txt 27 40 " "$out"; then
+    echo "FAIL: batch did not run past a missing file"
+    fail=1
+fi
+
+if ! ./gol_libtest; then
+    fail=1
+fi
+# the library, stepped in many calls and through a snapshot, gives print's boards
+for f in glidergun.txt pentadec.txt spaceship.txt; do
+    for w in wrap nowrap; do
+        boards $f $w hide -n 137 > "$ref"
+        if ! ./gol_libtest $f $w 137 > "$out" || ! cmp -s "$ref" "$out"; then
+            echo "FAIL: $f $w, the library differs from print"
+            fail=1
+        fi
+    done
+done
+
+if [ $fail -eq 0 ]; then
+    echo "test: scalar, $engines and tiles agree on every pattern, no allocations during a run, no frames lost"
+fi
+exit $fail
@@ -0,0 +1,208 @@
+/* Ethan Perry - Project 1: Conway's Game of Life - gol_tile.c
+ * This file is the temporally blocked (tiled) mode. Stepping the whole board once per
+ * generation streams it through memory twice, so on big boards the kernel waits on memory
+ * rather than doing math. Here the board is cut into cache sized tiles. Each tile is
+ * copied into a scratch board together with a halo k cells wide, stepped k generations
+ * in cache, and only its centre is written back. Every generation the halo's outer ring
+ * goes stale, so after k generations exactly the tile itself is still correct.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol_tile.h"
+#include "gol_io.h"
+#include "gol_sim.h"
+
+/* create_tiler(const gol_board*, int, int, int, row_fn);
+ * Create tiler allocates the two scratch boards one tile plus its halo needs. A tile is
+ * never larger than the board, so small boards are not stepped as mostly halo.
+ * @param board: the board the tiles are cut from
+ * @param k: generations advanced per pass (halo width in cells)
+ * @param trows: rows in a tile
+ * @param tcols: columns in a tile, rounded up to whole words
+ * @param kernel: row kernel to step the tiles with
+ * @return: the tiler
+ */
+gol_tiler* create_tiler(const gol_board* board, int k, int trows, int tcols, row_fn kernel) {
+    gol_tiler* tiler = malloc(sizeof(gol_tiler));
+    if (tiler == NULL) {
+        printf("error: unable to allocate a tiler\n");
+        exit(-1);
+    }
+    int twords = (tcols + GOL_WORD_BITS - 1) / GOL_WORD_BITS;
+    tiler->k = k;
+    tiler->trows = (trows < board->row) ? trows : board->row;
+    tiler->twords = (twords < board->words) ? twords : board->words;
+    tiler->hwords = (k + GOL_WORD_BITS - 1) / GOL_WORD_BITS;
+    tiler->kernel = kernel;
+
+    int srows = tiler->trows + 2 * k;
+    int swords = tiler->twords + 2 * tiler->hwords;
+    tiler->a = create_empty_board(srows, swords * GOL_WORD_BITS);
+    tiler->b = create_empty_board(srows, swords * GOL_WORD_BITS);
+    tiler->mask = malloc(swords * sizeof(uint64_t));
+    if (tiler->mask == NULL) {
+        printf("error: unable to allocate a tile of %d words\n", swords);
+        exit(-1);
+    }
+    return tiler;
+}
+
+/* read_bits(const uint64_t*, int, long, int);
+ * Read bits reads n cells (1 to 64) of a packed row starting at column c, from at most
+ * two words. The row has words words, bits past them read as dead.
+ * @return: the n cells, column c in bit 0, the rest of the word clear
+ */
+static inline uint64_t read_bits(const uint64_t* row, int words, long c, int n) {
+    long w = c / GOL_WORD_BITS;
+    int s = c % GOL_WORD_BITS;
+    uint64_t bits = row[w] >> s;
+    if (s > 0 && w + 1 < words) {
+        bits |= row[w + 1] << (GOL_WORD_BITS - s);
+    }
+    return (n < GOL_WORD_BITS) ? bits & ((~(uint64_t)0) >> (GOL_WORD_BITS - n)) : bits;
+}
+
+/* fetch_bits(const gol_board*, int, long, int);
+ * Fetch bits reads the 64 cells of row r starting at column c, a multiple of 64 that
+ * may lie off either edge of the board. With wrap those columns come from the other side, taken a run of
+ * columns at a time (more than one run only on boards narrower than a word), with
+ * nowrap they are dead. Word aligned reads inside the board are a single load.
+ * @return: the 64 cells, column c in bit 0
+ */
+static uint64_t fetch_bits(const gol_board* board, int r, long c, int wrap) {
+    long col = board->col;
+    const uint64_t* cells = board_row(board, r);
+    if (c >= 0 && (wrap ? c + GOL_WORD_BITS <= col : c < (long)board->words * GOL_WORD_BITS)) {
+        return cells[c / GOL_WORD_BITS];
+    }
+    if (!wrap) {
+        long lo = (c > 0) ? c : 0;
+        long hi = (c + GOL_WORD_BITS < col) ? c + GOL_WORD_BITS : col;
+        return (lo < hi) ? read_bits(cells, board->words, lo, (int)(hi - lo)) << (lo - c) : 0;
+    }
+    uint64_t bits = 0;
+    long cc = (c % col + col) % col;
+    for (int i = 0; i < GOL_WORD_BITS; ) {
+        int n = (col - cc < GOL_WORD_BITS - i) ? (int)(col - cc) : GOL_WORD_BITS - i;
+        bits |= read_bits(cells, board->words, cc, n) << i;
+        i += n;
+        cc = 0;
+    }
+    return bits;
+}
+
+/* col_mask(long, int);
+ * @return: bits of the 64 columns starting at c that are on a board col cells wide
+ */
+static uint64_t col_mask(long c, int col) {
+    long lo = (c > 0) ? c : 0;
+    long hi = (c + GOL_WORD_BITS < col) ? c + GOL_WORD_BITS : col;
+    if (lo >= hi) {
+        return 0;
+    }
+    int n = (int)(hi - lo);
+    return ((n < GOL_WORD_BITS) ? (~(uint64_t)0) >> (GOL_WORD_BITS - n) : ~(uint64_t)0) << (lo - c);
+}
+
+/* gather_tile(gol_tiler*, const gol_board*, int, int, int);
+ * Copies the tile whose top left word is (r0, w0) and its halo into the scratch board a.
+ * Rows and columns off the board come from the other side (wrap) or are dead (nowrap).
+ * The nowrap column mask for the tile is filled in at the same time.
+ */
+static void gather_tile(gol_tiler* tiler, const gol_board* old, int r0, int w0, int wrap) {
+    int row = old->row, k = tiler->k;
+    long c0 = (long)(w0 - tiler->hwords) * GOL_WORD_BITS;
+    int swords = tiler->twords + 2 * tiler->hwords;
+
+    for (int j = 0; j < swords; j++) {
+        tiler->mask[j] = wrap ? ~(uint64_t)0 : col_mask(c0 + (long)j * GOL_WORD_BITS, old->col);
+    }
+    for (int i = 0; i < tiler->a->row; i++) {
+        int r = r0 - k + i;
+        uint64_t* dst = board_row(tiler->a, i);
+        // rows off a nowrap board are dead in both scratch boards and never stepped
+        if (!wrap && (r < 0 || r >= row)) {
+            memset(dst, 0, swords * sizeof(uint64_t));
+            memset(board_row(tiler->b, i), 0, swords * sizeof(uint64_t));
+            continue;
+        }
+        r = (r % row + row) % row;
+        // tiles away from the left and right edge are one straight copy
+        if (c0 >= 0 && c0 + (long)swords * GOL_WORD_BITS <= (wrap ? old->col : (long)old->words * GOL_WORD_BITS)) {
+            memcpy(dst, board_row(old, r) + c0 / GOL_WORD_BITS, swords * sizeof(uint64_t));
+            continue;
+        }
+        for (int j = 0; j < swords; j++) {
+            dst[j] = fetch_bits(old, r, c0 + (long)j * GOL_WORD_BITS, wrap);
+        }
+    }
+}
+
+/* step_tile(gol_tiler*, int, int, int);
+ * Steps the scratch tile k generations. Generation s only needs rows s to srows - s,
+ * the rest of the halo is already stale. With nowrap, cells off the board are cleared
+ * after every generation so they stay dead like the board's edge.
+ * @return: the scratch board holding generation k
+ */
+static gol_board* step_tile(gol_tiler* tiler, int r0, int row, int wrap) {
+    gol_board* cur = tiler->a;
+    gol_board* next = tiler->b;
+    int srows = cur->row, swords = tiler->twords + 2 * tiler->hwords;
+    // on a nowrap board only scratch rows that are on the board are stepped
+    int lo = wrap ? 0 : (tiler->k - r0 > 0 ? tiler->k - r0 : 0);
+    int hi = wrap ? srows : (row - r0 + tiler->k < srows ? row - r0 + tiler->k : srows);
+
+    for (int s = 1; s <= tiler->k; s++) {
+        int r1 = (s > lo) ? s : lo;
+        int r2 = (srows - s < hi) ? srows - s : hi;
+        step_rows(tiler->kernel, cur, next, r1, r2, 0, &golRule);
+        for (int i = r1; i < r2 && !wrap; i++) {
+            uint64_t* dst = board_row(next, i);
+            for (int j = 0; j < swords; j++) {
+                dst[j] &= tiler->mask[j];
+            }
+        }
+        swap_board(&cur, &next);
+    }
+    return cur;
+}
+
+/* tile_pass(gol_tiler*, const gol_board*, gol_board*, int);
+ * Advances the whole board k generations, tile by tile. Only the centre of each stepped
+ * tile is written to new, with the padding bits of the last word of a row cleared.
+ * @param tiler: scratch space from create_tiler
+ * @param old: packed board of the Nth iteration
+ * @param new: packed board the N+kth iteration is written to
+ * @param wrap: 1 to wrap around the board, 0 for dead edges
+ */
+void tile_pass(gol_tiler* tiler, const gol_board* old, gol_board* new, int wrap) {
+    int last = old->words - 1;
+    uint64_t lastMask = ~(uint64_t)0 >> (GOL_WORD_BITS - 1 - (old->col - 1) % GOL_WORD_BITS);
+
+    for (int r0 = 0; r0 < old->row; r0 += tiler->trows) {
+        for (int w0 = 0; w0 <= last; w0 += tiler->twords) {
+            gather_tile(tiler, old, r0, w0, wrap);
+            gol_board* done = step_tile(tiler, r0, old->row, wrap);
+            // copy the centre of the tile back, clipped to the board
+            for (int i = 0; i < tiler->trows && r0 + i < old->row; i++) {
+                const uint64_t* src = board_row(done, tiler->k + i) + tiler->hwords;
+                uint64_t* dst = board_row(new, r0 + i) + w0;
+                for (int j = 0; j < tiler->twords && w0 + j <= last; j++) {
+                    dst[j] = (w0 + j == last) ? src[j] & lastMask : src[j];
+                }
+            }
+        }
+    }
+}
+
+/* free_tiler(gol_tiler**);
+ * Frees the scratch boards and the tiler, and sets the caller's pointer to NULL
+ */
+void free_tiler(gol_tiler** ptiler) {
+    free_array(&(*ptiler)->a);
+    free_array(&(*ptiler)->b);
+    free((*ptiler)->mask);
+    free(*ptiler);
+    *ptiler = NULL;
+}
@@ -0,0 +1,23 @@
+#ifndef GOL_TILE_H
+#define GOL_TILE_H
+
+#include "gol_board.h"
+#include "gol_swar.h"
+
+// scratch space and settings for stepping the board one tile at a time
+typedef struct gol_tiler {
+    int k;              // generations advanced per pass
+    int trows;          // rows in a tile
+    int twords;         // words (64 columns each) in a tile
+    int hwords;         // words of halo on each side, enough for k columns
+    gol_board* a;       // tile plus halo, stepped back and forth with b
+    gol_board* b;
+    uint64_t* mask;     // per halo word, which cells are on the board (nowrap)
+    row_fn kernel;      // row kernel the tile is stepped with
+} gol_tiler;
+
+gol_tiler* create_tiler(const gol_board*, int, int, int, row_fn);
+void tile_pass(gol_tiler*, const gol_board*, gol_board*, int);
+void free_tiler(gol_tiler**);
+
+#endif